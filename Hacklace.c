@@ -34,9 +34,24 @@ Disclaimer:			This software is provided by the copyright holder "as is" and any
 #include <avr/pgmspace.h>
 #include <avr/eeprom.h>
 #include <avr/sleep.h>
-#include <util/delay.h>
+#include <avr/wdt.h>
 #include "config.h"
 #include "dot_matrix.h"
+#include "link.h"
+#include "stream.h"
+
+
+#if CLOCK_GOVERNOR && (LINK_NODES > 0)
+	#error "The baud rate of the daisy chain depends on the system clock, so it does not work with the clock governor"
+#endif
+
+#if (AUTO_SLEEP_DELAY > 0) && (LINK_NODES > 0)
+	#error "The energy scheduler powers down a single board and does not work with the daisy chain"
+#endif
+
+#if (AUTO_SLEEP_DELAY > 0) && (AUTO_SLEEP_DELAY <= BURST_LENGTH)
+	#error "AUTO_SLEEP_DELAY must be longer than BURST_LENGTH"
+#endif
 
 
 /*********
@@ -51,15 +66,63 @@ FUSES =
 };
 
 
+/*************
+ * constants *
+ *************/
+
+// push button state of the interrupts in GPIOR2 (single cycle sbis / sbic / sbi / cbi)
+#define PB_FLAGS		GPIOR2
+#define PB_PRESSED		0					// debounced button level (must be bit 0)
+#define PB_BOUNCING		1					// debounce time running, edges are ignored
+#define PB_BUSY			2					// gesture or debounce time running, ButtonTick() needed
+
+
 /********************
  * global variables *
  ********************/
 
 uint8_t scroll_speed = 14;					// scrolling speed (0 = fastest)
-volatile uint8_t button = PB_ACK;			// button event
 volatile uint8_t scroll_enabled = 0;
+volatile uint8_t sys_ticks = 0;			// incremented by the system timer
+
+uint8_t clock_div = 0;						// system clock = F_CPU >> clock_div
+uint8_t sys_timer_step = OCR0B_CYCLE_TIME(0);	// timer 0 counts per system tick
+uint16_t column_freq = COLUMN_FREQ;			// display column frequency [Hz]
 
 unsigned int seed EEMEM;
+uint8_t brightness_stored EEMEM;			// index of brightness_levels
+
+const uint8_t brightness_levels[] PROGMEM = {BRIGHTNESS_LEVELS};
+uint8_t brightness_index;
+uint8_t brightness;							// column lit for brightness / BRIGHTNESS_STEPS of its slot
+
+// energy scheduler and battery estimation
+volatile uint8_t wdt_fired;					// set by the watchdog interrupt
+volatile uint8_t doze_due = 0;				// no button event for AUTO_SLEEP_DELAY seconds
+uint16_t idle_seconds = 0;					// seconds without a button event (system timer)
+uint8_t second_ticks = 0;
+uint32_t time_active;						// seconds awake (system timer)
+uint32_t time_asleep;						// seconds in power down (counted by the watchdog, see WatchdogSleep)
+uint32_t time_active_stored EEMEM;
+uint32_t time_asleep_stored EEMEM;
+
+#if STREAM
+	volatile uint8_t stream_hold = 0;		// system ticks until the generations go on after a streamed frame
+#else
+	#define stream_hold		0
+#endif
+
+const uint8_t scroll_speeds[] PROGMEM = {SCROLL_SPEEDS};
+uint8_t speed_index = 0;
+
+// push button: state machine (interrupt context) and event queue (read by main)
+enum {PB_IDLE, PB_DOWN, PB_UP, PB_DOWN2, PB_HELD};
+uint8_t pb_state = PB_IDLE;
+uint8_t pb_time;							// sys_ticks of the last accepted edge
+uint8_t pb_debounce = 0;					// system ticks until PB_BOUNCING ends
+volatile uint8_t pb_queue[PB_QUEUE_SIZE];
+volatile uint8_t pb_head = 0;				// written by the interrupts only
+volatile uint8_t pb_tail = 0;				// written by main() only
 
 
 /**********
@@ -97,39 +160,426 @@ void InitHardware(void)
 	PORTB |= ~DISP_MASK_B;
 	PORTD |= ~DISP_MASK_D;
 	
-	// timer 0
+	// timer 0 (system timer)
 	TCCR0A = (0<<WGM00);				// timer mode = normal
 	TCCR0B = (5<<CS00);					// prescaler = 1:1024
-	OCR0A = OCR0A_CYCLE_TIME;
-	OCR0B = OCR0B_CYCLE_TIME;
-	TIMSK |= (1<<OCIE0B)|(1<<OCIE0A);
+	OCR0B = sys_timer_step;
+
+	// timer 1 (display multiplexing, compare B blanks the display for dimming)
+	brightness_index = eeprom_read_byte(&brightness_stored);
+	if (brightness_index >= sizeof(brightness_levels)) {
+		brightness_index = 0;			// erased EEPROM
+	}
+	brightness = pgm_read_byte(&brightness_levels[brightness_index]);
+	TCCR1A = 0;
+	TCCR1B = (1<<WGM12)|(2<<CS10);		// timer mode = CTC (top = OCR1A), prescaler = 1:8
+	OCR1A = OCR1A_CYCLE_TIME(COLUMN_FREQ, 0);
+	OCR1B = OCR1B_DIM_TIME(OCR1A_CYCLE_TIME(COLUMN_FREQ, 0), brightness);
+	TIMSK |= (1<<OCIE0B)|(1<<OCIE1A)|(1<<OCIE1B);
+
+	// push button (pin change interrupt, also wakes the controller from power down)
+	PB_FLAGS = 0;
+	PCMSK2 = (1<<PCINT17);
+	GIMSK = (1<<PCIE2);
+
+	#if STREAM
+		streamInit();					// USART (receive interrupt)
+	#endif
 
 	srand(eeprom_read_word(&seed));
+	time_active = eeprom_read_dword(&time_active_stored);
+	time_asleep = eeprom_read_dword(&time_asleep_stored);
+	if (time_active == 0xFFFFFFFF) {		// erased EEPROM
+		time_active = 0;
+		time_asleep = 0;
+	}
 	
 }
 
 
+/*======================================================================
+	Function:		SetColumnFreq
+	Input:			column frequency [Hz] (T1_CLOCK / 65536 .. T1_CLOCK / 2)
+	Output:			none
+	Description:	Set the display column multiplexing frequency at runtime.
+					The refresh rate of the whole display is freq / DISP_COLUMNS.
+					As timer 1 runs in CTC mode the period is exact to one
+					timer 1 clock (2 us at 4 MHz). The frequency is kept
+					when the system clock changes (see SetClockDiv). The
+					blanking time of compare B follows the brightness.
+======================================================================*/
+void SetColumnFreq(uint16_t freq)
+{
+	uint16_t top = OCR1A_CYCLE_TIME(freq, clock_div);
+	uint16_t dim = OCR1B_DIM_TIME(top, brightness);
+	uint8_t sreg = SREG;
+
+	column_freq = freq;
+	cli();								// 16 bit registers -> access with interrupts disabled
+	OCR1A = top;
+	OCR1B = dim;
+	if (TCNT1 > top) {
+		TCNT1 = 0;						// avoid waiting for a full timer wrap-around
+	}
+	SREG = sreg;
+}
+
+
+/*======================================================================
+	Function:		NextBrightness
+	Input:			none
+	Output:			none
+	Description:	Select the next level of BRIGHTNESS_LEVELS. The level is
+					kept in EEPROM over power cycles.
+======================================================================*/
+void NextBrightness(void)
+{
+	if (++brightness_index == sizeof(brightness_levels)) {
+		brightness_index = 0;
+	}
+	brightness = pgm_read_byte(&brightness_levels[brightness_index]);
+	SetColumnFreq(column_freq);
+	eeprom_update_byte(&brightness_stored, brightness_index);
+}
+
+
+/*======================================================================
+	Function:		SetClockDiv
+	Input:			clock divider (0 .. CLOCK_DIV_MAX, clock = F_CPU >> div)
+	Output:			none
+	Description:	Change the system clock at runtime and recompute the
+					timer constants, so that the system tick, the scrolling
+					speed and the display refresh rate stay the same.
+					F_CPU remains the maximum clock, i. e. _delay_ms() and
+					the baud rate of the USART are only valid at div = 0.
+======================================================================*/
+void SetClockDiv(uint8_t div)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+	CLKPR = (1<<CLKPCE);				// timed sequence: write the prescaler within 4 cycles
+	CLKPR = div;
+	clock_div = div;
+	sys_timer_step = OCR0B_CYCLE_TIME(div);
+	SREG = sreg;
+	SetColumnFreq(column_freq);
+}
+
+
+/*======================================================================
+	Function:		ClockGovernor
+	Input:			duration of the last generation [timer 0 counts]
+	Output:			none
+	Description:	Adapt the system clock to the load. A timer 0 count
+					is 1024 CPU cycles at any clock, whereas a system tick
+					shrinks to sys_timer_step counts when the clock is
+					lowered. The clock is raised if a generation takes half
+					a tick or more and lowered if it takes less than an
+					eighth, so that halving the clock never crosses the
+					upper limit and the governor does not oscillate.
+======================================================================*/
+static inline void ClockGovernor(uint8_t busy)
+{
+	#if CLOCK_GOVERNOR
+		if ((busy >= sys_timer_step / 2) && (clock_div > 0)) {
+			SetClockDiv(clock_div - 1);
+		}
+		else if ((busy < sys_timer_step / 8) && (clock_div < CLOCK_DIV_MAX)) {
+			SetClockDiv(clock_div + 1);
+		}
+	#endif
+}
+
+
+/*======================================================================
+	Function:		ButtonPush
+	Input:			event (PB_SHORT, PB_LONG, PB_DOUBLE, PB_DOUBLE_LONG)
+	Output:			none
+	Description:	Append an event to the queue (interrupt context). An
+					event is dropped if the queue is full.
+======================================================================*/
+static void ButtonPush(uint8_t event)
+{
+	uint8_t next = (pb_head + 1) & (PB_QUEUE_SIZE - 1);
+
+	if (next != pb_tail) {
+		pb_queue[pb_head] = event;
+		pb_head = next;
+	}
+}
+
+
+/*======================================================================
+	Function:		ButtonChange
+	Input:			new button level (1 = pressed)
+	Output:			none
+	Description:	Gesture state machine, called for every debounced edge
+					(interrupt context). A release ends a double press; the
+					end of a short press is only known when no second
+					press follows within PB_DOUBLE_DELAY (see ButtonTick).
+======================================================================*/
+static void ButtonChange(uint8_t pressed)
+{
+	if (pressed) {
+		PB_FLAGS |= (1<<PB_PRESSED);
+	}
+	else {
+		PB_FLAGS &= ~(1<<PB_PRESSED);
+	}
+	PB_FLAGS |= (1<<PB_BOUNCING);
+	PB_FLAGS |= (1<<PB_BUSY);
+	pb_time = sys_ticks;
+	pb_debounce = PB_DEBOUNCE;
+	switch (pb_state) {
+		case PB_IDLE:
+			if (pressed) pb_state = PB_DOWN;
+			break;
+		case PB_DOWN:
+			if (!pressed) pb_state = PB_UP;
+			break;
+		case PB_UP:
+			if (pressed) pb_state = PB_DOWN2;
+			break;
+		case PB_DOWN2:
+			if (!pressed) {
+				ButtonPush(PB_DOUBLE);
+				pb_state = PB_IDLE;
+			}
+			break;
+		default:							// PB_HELD: long press, wait for the release
+			if (!pressed) pb_state = PB_IDLE;
+	}
+}
+
+
+/*======================================================================
+	Function:		ButtonTick
+	Input:			none
+	Output:			none
+	Description:	Time outs of the button, called by the system timer only
+					while PB_BUSY is set: end of the debounce time (an edge
+					ignored during the bounce is caught up), long press and
+					end of a short press.
+======================================================================*/
+static void ButtonTick(void)
+{
+	uint8_t pressed;
+
+	if ((PB_FLAGS & (1<<PB_BOUNCING)) && (--pb_debounce == 0)) {
+		PB_FLAGS &= ~(1<<PB_BOUNCING);
+		pressed = ((PB_PIN & PB_MASK) == 0);
+		if (pressed != (PB_FLAGS & (1<<PB_PRESSED))) {
+			ButtonChange(pressed);
+		}
+	}
+	if ((pb_state == PB_DOWN) || (pb_state == PB_DOWN2)) {
+		if ((uint8_t)(sys_ticks - pb_time) >= PB_LONGPRESS_DELAY) {
+			ButtonPush((pb_state == PB_DOWN) ? PB_LONG : PB_DOUBLE_LONG);
+			pb_state = PB_HELD;
+		}
+	}
+	else if (pb_state == PB_UP) {
+		if ((uint8_t)(sys_ticks - pb_time) >= PB_DOUBLE_DELAY) {
+			ButtonPush(PB_SHORT);
+			pb_state = PB_IDLE;
+		}
+	}
+	if ((pb_state == PB_IDLE) && !(PB_FLAGS & (1<<PB_BOUNCING))) {
+		PB_FLAGS &= ~(1<<PB_BUSY);
+	}
+}
+
+
+/*======================================================================
+	Function:		ButtonEvent
+	Input:			none
+	Output:			next button event, PB_NONE if there is none
+	Description:	Take the oldest event from the queue (main context).
+======================================================================*/
+static uint8_t ButtonEvent(void)
+{
+	uint8_t event = PB_NONE;
+
+	if (pb_tail != pb_head) {
+		event = pb_queue[pb_tail];
+		pb_tail = (pb_tail + 1) & (PB_QUEUE_SIZE - 1);
+	}
+	return event;
+}
+
+
+/*======================================================================
+	Function:		ButtonIgnore
+	Input:			none
+	Output:			none
+	Description:	Discard all events and ignore the button until it is
+					released (e.g. the press that woke the controller up).
+======================================================================*/
+static void ButtonIgnore(void)
+{
+	cli();
+	pb_state = (PB_FLAGS & (1<<PB_PRESSED)) ? PB_HELD : PB_IDLE;
+	PB_FLAGS |= (1<<PB_BUSY);
+	pb_tail = pb_head;
+	sei();
+}
+
+
+/*======================================================================
+	Function:		Idle
+	Input:			none
+	Output:			none
+	Description:	Sleep until the next interrupt (idle mode, the timers
+					keep running). An event raised by an interrupt right
+					before the sleep instruction is seen after the next
+					display interrupt at the latest.
+======================================================================*/
+static void Idle(void)
+{
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_mode();
+}
+
+
+/*======================================================================
+	Function:		WaitTicks
+	Input:			number of system ticks
+	Output:			none
+	Description:	Wait with interrupts enabled. Unlike _delay_ms() the
+					duration does not depend on the system clock.
+======================================================================*/
+static void WaitTicks(uint8_t ticks)
+{
+	uint8_t start = sys_ticks;
+
+	while ((uint8_t)(sys_ticks - start) < ticks) {
+		Idle();
+	}
+}
+
+
+/*======================================================================
+	Function:		WatchdogSleep
+	Input:			none
+	Output:			1 if the watchdog has woken the controller up, 0 if the
+					button has
+	Description:	Power down for BURST_PERIOD seconds at most. The watchdog
+					runs in interrupt mode only, it never resets the
+					controller. The button is checked with interrupts
+					disabled; sei() takes effect after the next instruction,
+					so an edge in between wakes the controller from
+					sleep_cpu() instead of being missed. All timers stop in
+					power down, so a period cut short by the button is
+					counted as half a period: right on average for long
+					sleeps, but a sleep of a few seconds is counted as 4 s
+					(8 s + 4 s for one of 8.5 s), so many short sleeps make
+					time_asleep too high.
+======================================================================*/
+static uint8_t WatchdogSleep(void)
+{
+	uint8_t slept = 0;
+
+	wdt_fired = 0;
+	cli();
+	WDTCR = (1<<WDCE)|(1<<WDE);		// timed sequence: change the prescaler within 4 cycles
+	WDTCR = (1<<WDIE)|BURST_WDP;
+	wdt_reset();					// the period starts now, not at some count of the last one
+	if (!(PB_FLAGS & (1<<PB_BUSY))) {	// no edge since the button was last idle
+		set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		slept = 1;
+	}
+	cli();
+	WDTCR = (1<<WDCE)|(1<<WDE);
+	WDTCR = 0;
+	sei();
+	if (wdt_fired) {
+		time_asleep += BURST_PERIOD;
+	}
+	else if (slept) {
+		time_asleep += BURST_PERIOD / 2;	// woken by the button: on average half a period
+	}
+	return wdt_fired;
+}
+
+
+/*======================================================================
+	Function:		ResetIdle
+	Input:			none
+	Output:			none
+	Description:	Restart the time until the energy scheduler dozes off.
+======================================================================*/
+static void ResetIdle(void)
+{
+	cli();
+	idle_seconds = 0;
+	doze_due = 0;
+	sei();
+}
+
+
+#if AUTO_SLEEP_DELAY > 0
+/*======================================================================
+	Function:		Doze
+	Input:			none
+	Output:			none
+	Description:	Energy scheduler: power down with the world kept in the
+					display memory until the watchdog starts the next burst
+					of BURST_LENGTH seconds (the generations simply go on,
+					there is no reseed), or until the button brings the
+					device back to normal operation.
+======================================================================*/
+static void Doze(void)
+{
+	TIMSK &= ~((1<<OCIE1A)|(1<<OCIE1B));	// stop the display
+	dmBlank();
+	if (WatchdogSleep()) {
+		cli();
+		idle_seconds = AUTO_SLEEP_DELAY - BURST_LENGTH;
+		doze_due = 0;
+		sei();
+	}
+	else {
+		ButtonIgnore();						// the wake-up press does nothing else
+		ResetIdle();
+	}
+	TIFR = (1<<OCF1A)|(1<<OCF1B);
+	TIMSK |= (1<<OCIE1A)|(1<<OCIE1B);
+}
+#endif
+
+
 /*======================================================================
 	Function:		GoToSleep
 	Input:			none
 	Output:			none
 	Description:	Put the controller into sleep mode and prepare for
-					wake-up by a pin change interrupt.
+					wake-up by a pin change interrupt. The watchdog wakes
+					it shortly every BURST_PERIOD seconds to count the time
+					asleep. The time counters are saved in EEPROM.
 ======================================================================*/
 void GoToSleep(void)
 {
+	uint32_t active;
+
 	scroll_enabled = 0;
 	eeprom_write_word(&seed, rand());
+	cli();
+	active = time_active;			// written by the system timer
+	sei();
+	eeprom_update_dword(&time_active_stored, active);
+	eeprom_update_dword(&time_asleep_stored, time_asleep);
 	dmClearDisplay();
-	_delay_ms(1000);
-	GIFR = (1<<PCIF2);				// clear interrupt flag
-	PCMSK2 = (1<<PCINT17);			// enable pin change interrupt
-	GIMSK = (1<<PCIE2);				// enable pin change interrupt
-	set_sleep_mode(SLEEP_MODE_PWR_DOWN);
-	sleep_mode();
-	GIMSK = 0;						// disable all external interrupts (including pin change)
+	WaitTicks(SYS_TIMER_FREQ);		// 1 s
+	while (WatchdogSleep());		// until the button changes (pin change interrupt)
+	ButtonIgnore();
+	ResetIdle();
 	dmWakeUp();
-	_delay_ms(500);
+	WaitTicks(SYS_TIMER_FREQ / 2);	// 0.5 s
 	scroll_enabled = 1;
 }
 
@@ -140,25 +590,93 @@ void GoToSleep(void)
 
 int main(void)
 {
+	uint8_t event;
+	#if LOOKAHEAD_FRAMES > 0
+		uint8_t start;
+	#endif
+	#if STREAM
+		const uint8_t* frame;
+	#endif
+
 	InitHardware();
 	dmInit();
 	dmWakeUp();
 	sei();									// enable interrupts
 
 	GoToSleep();
-	button |= PB_ACK;
 
 	while(1)
 	{
-		if (button == PB_RELEASE) {			// short button press
-			button |= PB_ACK;
+		event = ButtonEvent();
+		if (event != PB_NONE) {
+			ResetIdle();
 		}
-		
-		if (button == PB_LONGPRESS) {		// button pressed for some seconds
-			dmClearDisplay();
-			GoToSleep();
-			button |= PB_ACK;
+		switch (event) {
+			case PB_SHORT:					// new world
+				#if LINK_NODES > 0
+					linkRequestReseed(&link);	// all boards at once, decided by the master
+				#else
+					scroll_enabled = 0;		// the system timer interrupt uses the display memory
+					dmWakeUp();
+					scroll_enabled = 1;
+				#endif
+				break;
+			case PB_DOUBLE:					// next scrolling speed
+				if (++speed_index == sizeof(scroll_speeds)) {
+					speed_index = 0;
+				}
+				scroll_speed = pgm_read_byte(&scroll_speeds[speed_index]);
+				break;
+			case PB_DOUBLE_LONG:			// next brightness
+				NextBrightness();
+				break;
+			case PB_LONG:					// button pressed for some seconds
+				dmClearDisplay();
+				GoToSleep();
+				break;
 		}
+
+		#if STREAM
+			frame = streamFrame();
+			if (frame) {					// frame from the host: pause the generations and show it
+				stream_hold = STREAM_HOLD;
+				dmShowFrame(frame);
+				streamRelease();
+				ResetIdle();
+			}
+		#endif
+
+		#if AUTO_SLEEP_DELAY > 0
+			if (doze_due) {
+				Doze();
+			}
+		#endif
+
+		#if LINK_NODES > 0
+			if (link.ready) {				// edge columns of the neighbours have arrived
+				if (link.reseed) {			// the master has decided on a new world
+					dmWakeUp();
+					link.changed = 1;
+				}
+				else {
+					dmScroll();
+				}
+				link.ready = 0;
+			}
+			else {
+				Idle();
+			}
+		#elif LOOKAHEAD_FRAMES > 0
+			start = TCNT0;
+			if (dmProduce()) {				// compute generations in advance
+				ClockGovernor(TCNT0 - start);
+			}
+			else {
+				Idle();						// ring is full
+			}
+		#else
+			Idle();							// everything happens in the interrupts
+		#endif
 		
 	} // of while(1)
 }
@@ -168,67 +686,81 @@ int main(void)
  * interrupt service routines *
  ******************************/
 
-ISR(TIMER0_COMPA_vect)
-// display interrupt
-{
-	OCR0A += OCR0A_CYCLE_TIME;				// setup next cycle
-
-	dmDisplay();							// show next column on dot matrix display
-}
+// The display interrupt (TIMER1_COMPA_vect) is part of dot_matrix.c.
 
 
 ISR(TIMER0_COMPB_vect)
 // system timer interrupt
 {
 	static uint8_t scroll_timer = 1;
-	static uint8_t pb_timer = 0;			// push button timer
-	uint8_t temp;
+	#if (LINK_NODES == 0) && (LOOKAHEAD_FRAMES == 0)
+		uint8_t temp;
+	#endif
 		
-	OCR0B += OCR0B_CYCLE_TIME;				// setup next cycle
+	OCR0B += sys_timer_step;				// setup next cycle
+	sys_ticks++;
 
 	if (scroll_timer) {
 		scroll_timer--;
 	}
 	else {
 		scroll_timer = scroll_speed;		// restart timer
-		if (scroll_enabled) {
-			TIMSK &= ~_BV(OCIE0B);
-			sei();
-			dmScroll();						// do a scrolling step
-			cli();
-			TIMSK |= _BV(OCIE0B);
+		if (scroll_enabled && !stream_hold) {
+			#if LINK_NODES > 0
+				linkStart(&link);			// master: exchange edges, main() computes the generation afterwards
+			#elif LOOKAHEAD_FRAMES > 0
+				dmNextFrame();				// generations are computed in advance by main()
+			#else
+				TIMSK &= ~_BV(OCIE0B);
+				sei();
+				temp = TCNT0;
+				dmScroll();					// do a scrolling step
+				cli();
+				TIMSK |= _BV(OCIE0B);
+				ClockGovernor(TCNT0 - temp);
+			#endif
 		}
 	}
 	
-	// push button sampling
-	temp = ~PB_PIN;							// sample push button
-	temp &= PB_MASK;						// extract push button state
-	if (temp == 0) {						// --- button not pressed ---
-		if (button & PB_PRESS) {			// former state = pressed?
-			button &= ~(PB_PRESS | PB_ACK);	// -> issue release event
+	#if STREAM
+		if (stream_hold) {
+			stream_hold--;					// not before the scrolling step: main() may be writing the display memory
 		}
-	}
-	else {									// --- button pressed ---
-		if ((button & PB_PRESS) == 0) {		// former state = button released?
-			button = PB_PRESS;				// issue new press event
-			pb_timer = PB_LONGPRESS_DELAY;	// start push button timer
-		}
-		else {
-			if (button == PB_PRESS) {		// holding key pressed
-				if (pb_timer == 0) {		// if push button timer has elapsed
-					button = PB_LONGPRESS;	// issue long event
+	#endif
+
+	// time counters and energy scheduler
+	if (++second_ticks == SYS_TIMER_FREQ) {
+		second_ticks = 0;
+		time_active++;
+		#if AUTO_SLEEP_DELAY > 0
+			if (idle_seconds < AUTO_SLEEP_DELAY) {
+				if (++idle_seconds == AUTO_SLEEP_DELAY) {
+					doze_due = 1;
 				}
-				else {
-					pb_timer--;
-				}
-			}			
-		}		
+			}
+		#endif
+	}
+
+	// push button time outs (the edges arrive by the pin change interrupt)
+	if (PB_FLAGS & (1<<PB_BUSY)) {
+		ButtonTick();
 	}
-	
 }
 
 
 ISR(PCINT_D_vect)
-// pin change interrupt (for wake-up)
+// pin change interrupt of the push button (also wakes the controller up)
+{
+	uint8_t pressed = ((PB_PIN & PB_MASK) == 0);
+
+	if (!(PB_FLAGS & (1<<PB_BOUNCING)) && (pressed != (PB_FLAGS & (1<<PB_PRESSED)))) {
+		ButtonChange(pressed);
+	}
+}
+
+
+ISR(WDT_OVERFLOW_vect)
+// watchdog interrupt (wakes the controller up from power down)
 {
+	wdt_fired = 1;
 }
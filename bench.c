@@ -0,0 +1,138 @@
+/*
+ * bench.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Cycle count benchmark, run in the simulator by "make report".
+					Timer 1 counts CPU cycles, the results are printed over the
+					USART as "cycles_<name> <count>" lines.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include "config.h"
+#include "dot_matrix.h"
+#include "life.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define RUNS		16					// number of measurements per benchmark (averaged)
+
+
+/**********
+ * macros *
+ **********/
+
+// measure the number of cycles spent in statement
+#define MEASURE(statement)				\
+	({									\
+		uint16_t __t__;					\
+		TCNT1 = 0;						\
+		statement;						\
+		__t__ = TCNT1;					\
+		__t__ - overhead;				\
+	})
+
+
+/********************
+ * global variables *
+ ********************/
+
+uint16_t overhead;						// cycles of an empty measurement
+
+void TIMER1_COMPA_vect(void);			// display interrupt of dot_matrix.c, called like a function
+void TIMER1_COMPB_vect(void);			// blanking (dimming) interrupt of dot_matrix.c
+
+
+/*************
+ * functions *
+ *************/
+
+static void PrintChar(char ch)
+{
+	while (!(UCSRA & (1<<UDRE)));
+	UDR = ch;
+}
+
+
+static void PrintResult(const char* name, uint32_t cycles)
+{
+	char buf[11];
+	char* p = buf + sizeof(buf) - 1;
+
+	while (pgm_read_byte(name)) {
+		PrintChar(pgm_read_byte(name++));
+	}
+	PrintChar(' ');
+	*p = 0;
+	do {
+		*--p = '0' + cycles % 10;
+		cycles /= 10;
+	} while (cycles);
+	while (*p) {
+		PrintChar(*p++);
+	}
+	PrintChar('\n');
+}
+
+
+int main(void)
+{
+	uint8_t src[DISP_MAX], dst[DISP_MAX];
+	uint32_t kernel = 0, scroll = 0, display = 0, blank = 0;
+	uint8_t i, x;
+
+	UCSRB = (1<<TXEN);
+	TCCR1A = 0;
+	TCCR1B = (1<<CS10);					// timer 1 counts cpu cycles
+	overhead = 0;
+	overhead = MEASURE(;);
+
+	dmInit();
+	srand(1);
+	for (i = 0; i < RUNS; i++) {
+		for (x = 0; x < DISP_MAX; x++) {
+			src[x] = rand() % 0x80;
+		}
+		kernel += MEASURE(lifeStep(dst, src, DISP_MAX));
+		dmWakeUp();
+		scroll += MEASURE(dmScroll());
+		display += MEASURE(TIMER1_COMPA_vect());	// its reti sets the I bit, no interrupt is enabled
+		blank += MEASURE(TIMER1_COMPB_vect());
+	}
+
+	PrintResult(PSTR("cycles_kernel"), kernel / RUNS);
+	PrintResult(PSTR("cycles_scroll"), scroll / RUNS);
+	PrintResult(PSTR("cycles_display"), display / RUNS);
+	PrintResult(PSTR("cycles_blank"), blank / RUNS);
+
+	while (!(UCSRA & (1<<TXC)));		// wait until the last byte has been sent
+	cli();
+	sleep_mode();						// stops the simulator
+	return 0;
+}
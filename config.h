@@ -39,25 +39,70 @@ Disclaimer:			This software is provided by the copyright holder "as is" and any
 #endif
 
 // timing
-#define COLUMN_FREQ			1000		// display column frequency [Hz]
+#define COLUMN_FREQ			1000		// default display column frequency [Hz]
 #define SYS_TIMER_FREQ		100			// system timer frequency [Hz]
-#define OCR0A_CYCLE_TIME	(uint8_t)(F_CPU / 1024.0 / COLUMN_FREQ + 0.5);
-#define OCR0B_CYCLE_TIME	(uint8_t)(F_CPU / 1024.0 / SYS_TIMER_FREQ + 0.5);
+#define T1_PRESCALER		8			// prescaler of timer 1 (display multiplexing)
+#define T1_CLOCK			(F_CPU / T1_PRESCALER)				// timer 1 clock [Hz]
+#define OCR1A_CYCLE_TIME(f, div)	(uint16_t)((T1_CLOCK >> (div)) / (f) - 1)						// timer 1 CTC top value for column frequency f at clock F_CPU >> div
+#define OCR1B_DIM_TIME(top, b)	(uint16_t)(((uint32_t)(top) + 1) * (b) / BRIGHTNESS_STEPS)				// timer 1 compare B value which ends the lit part of a column slot at brightness b
+#define OCR0B_CYCLE_TIME(div)	(uint8_t)((((F_CPU / 1024 * 2 / SYS_TIMER_FREQ) >> (div)) + 1) >> 1)	// timer 0 counts per system tick at clock F_CPU >> div
+
+// brightness: a column is lit for b / BRIGHTNESS_STEPS of its slot, then the display is blanked until the next column
+#define BRIGHTNESS_STEPS	16			// resolution (power of 2)
+#define BRIGHTNESS_LEVELS	12, 6, 3, 1	// levels selected by a short press followed by a long press (< BRIGHTNESS_STEPS, first = default)
+
+// energy scheduler: after AUTO_SLEEP_DELAY seconds without a button event the device powers down
+// and the watchdog wakes it every BURST_PERIOD seconds for a burst of BURST_LENGTH seconds of animation
+#define AUTO_SLEEP_DELAY	300			// seconds (0 = off)
+#define BURST_WDP			((1<<WDP3)|(1<<WDP0))	// watchdog prescaler bits of BURST_PERIOD (8 s)
+#define BURST_PERIOD		8			// seconds (watchdog period, also used to count the time asleep)
+#define BURST_LENGTH		2			// seconds
+
+// clock governor: run the CPU at F_CPU >> clock_div as slow as the load permits
+#define CLOCK_GOVERNOR		0			// 1 = on, 0 = always run at F_CPU
+#define CLOCK_DIV_MAX		3			// slowest clock = F_CPU >> CLOCK_DIV_MAX (500 kHz)
+
+// daisy chain (shared world across several boards, see link.h)
+#ifndef LINK_NODES
+#define LINK_NODES			0			// number of boards in the ring (0 = stand-alone board)
+#endif
+#define LINK_BAUD			38400		// baud rate of the ring
+#define LINK_UBRR			(F_CPU / 8 / LINK_BAUD - 1)		// baud rate register value (double speed mode)
+
+// streaming mode: show the frames a host sends over the USART (see stream.h)
+#ifndef STREAM
+#define STREAM				0			// 1 = on, 0 = off
+#endif
+#define STREAM_BAUD			38400		// baud rate of the host connection
+#define STREAM_UBRR			(F_CPU / 8 / STREAM_BAUD - 1)	// baud rate register value (double speed mode)
+#define STREAM_HOLD			100			// system timer cycles after the last frame until the generations go on
+
+// look-ahead: number of generations computed in advance by main() (0 = off, else >= 3)
+#define LOOKAHEAD_FRAMES	0
+
+// pattern library: seed the patterns of patterns.h (generated by host/patenc) in turn, then a random soup
+#define PATTERN_LIBRARY		0			// 1 = on, 0 = random soups only
 
 // push button
 #define PB_PORT				PORTD
 #define PB_PIN				PIND
 #define PB_BIT				6			// bit number of the pin where the push button is connected
 #define PB_LONGPRESS_DELAY	100			// number of system timer cycles after which a longpress event is issued
+#define PB_DOUBLE_DELAY		30			// system timer cycles after a release in which a second press makes a double press
+#define PB_DEBOUNCE			3			// system timer cycles in which further edges of the button are ignored
+#define PB_QUEUE_SIZE		4			// button event queue (power of 2)
 
-// bit masks for push button events (do not change)
-#define PB_PRESS			(1<<0)					// 1 = pressed, 0 = released
-#define PB_RELEASE			(0<<0)
-#define PB_LONG				(1<<1)					// 1 = long press, 0 = short press
-#define PB_ACK				(1<<7)					// 1 = key event has been processed
-#define PB_LONGPRESS		(PB_PRESS|PB_LONG)
+// push button events (do not change)
+#define PB_NONE				0
+#define PB_SHORT			1
+#define PB_LONG				2
+#define PB_DOUBLE			3
+#define PB_DOUBLE_LONG		4			// short press, then a long press
 #define PB_MASK				(1<<PB_BIT)				// mask to extract button state
 
+// scrolling speeds selected by a double press (system timer cycles per scrolling step - 1)
+#define SCROLL_SPEEDS		14, 6, 2, 29
+
 // messages in EEPROM
 #define MSG_SIZE	256			// number of EEPROM bytes reserved for messages
 
@@ -30,7 +30,54 @@ Disclaimer:			This software is provided by the copyright holder "as is" and any
 #include <avr/pgmspace.h>
 #include <avr/eeprom.h>
 #include <stdlib.h>
+#include "config.h"
 #include "dot_matrix.h"
+#include "life.h"
+#include "link.h"
+
+
+#if (LINK_NODES > 0) && (LIFE_GENERATIONS > 1)
+	#error "The daisy chain exchanges a single halo column, so it needs LIFE_GENERATIONS = 1"
+#endif
+
+#if LOOKAHEAD_FRAMES > 0
+	#if (LOOKAHEAD_FRAMES < 3) || (LINK_NODES > 0)
+		#error "The look-ahead needs at least 3 frames and does not work with the daisy chain"
+	#endif
+	#define DISP_FRAMES		LOOKAHEAD_FRAMES	// display memory holds a ring of frames
+#else
+	#define DISP_FRAMES		1
+#endif
+
+#define DISP_PHASES		(DISP_COLUMNS + 1)	// the columns plus a phase with all columns off
+#define DISP_PORTS		3					// bytes of a port image (PORTA, PORTB, PORTD)
+
+// interrupt state in the general purpose I/O registers (sbis / sbic / in / out)
+#define DISP_COL		GPIOR0				// offset of the next column in the port image (DISP_PORTS * column)
+#define DISP_FLAGS		GPIOR1
+#define DISP_BUF		0					// port image shown (index of disp_ports)
+#define DISP_FLIP		1					// the other port image is new, switch to it at column 0
+
+#if PATTERN_LIBRARY
+	#if LINK_NODES > 0
+		#error "The pattern library seeds the world of a single board and does not work with the daisy chain"
+	#endif
+	#include "patterns.h"
+	#if PATTERN_ROWS != DISP_ROWS
+		#error "patterns.h has been generated for a different number of rows, run host/patenc again"
+	#endif
+#endif
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	const uint8_t* next;		// next byte in flash
+	uint8_t data;				// current byte
+	uint8_t mask;				// bit of data to be read next (0 = read the next byte)
+} bitstream_t;
 
 
 /********************
@@ -52,9 +99,8 @@ Disclaimer:			This software is provided by the copyright holder "as is" and any
 // The display memory contains all the data to be displayed. Of the display memory
 // only a small window, whose size matches the dot matrix display, is actually displayed.
 typedef struct {
-	uint8_t memory[DISP_MAX];	// display memory (every byte encodes a column)
+	uint8_t memory[DISP_MAX * DISP_FRAMES];	// display memory (every byte encodes a column)
 	uint8_t base;				// index of column 1 of currently displayed window
-	uint8_t curr_col;			// index of currently displayed column within window
 	uint8_t scroll_mode;		// lower nibble = increment of display base for each scrolling step (0 = off)
 	// bit 4 = direction (0 = forward, 1 = backward)
 	// bit 5 = bidirectional (0 = off, 1 = on)
@@ -65,6 +111,25 @@ typedef struct {
 
 display_t display;
 
+// Port images of the display window: the display interrupt only masks them
+// into the ports. dmUpdatePorts() writes the image not shown and sets
+// DISP_FLIP, the interrupt switches images before the first column.
+static uint8_t disp_ports[2][DISP_PHASES][DISP_PORTS];
+static uint8_t disp_blank[DISP_PORTS];		// all rows and columns off (dimming, column switch)
+
+#if LOOKAHEAD_FRAMES > 0
+	static volatile uint8_t frame_head;		// newest computed frame (written by main context only)
+	static volatile uint8_t frame_tail;		// frame currently displayed (written by the interrupt only)
+	static uint8_t frame_age;				// generations since the last reseed
+	uint8_t frames_late;					// number of ticks without a new frame (saturating)
+#endif
+
+#if PATTERN_LIBRARY
+	static const uint8_t* pattern_next = patterns;	// next pattern of the library
+	static uint8_t pattern_index;			// number of the next pattern
+	static uint8_t pattern_seeded;			// 1 = the current world comes from the library
+#endif
+
 /**********
  * makros *
  **********/
@@ -85,31 +150,17 @@ display_t display;
  *************/
 
 /*======================================================================
-	Function:		dmInit
-	Input:			none
-	Output:			none
-	Description:	Initialize the hardware.
-======================================================================*/
-void dmInit(void)
-{
-	dmClearDisplay();
-	display.scroll_mode = 0;
-	display.scroll_delay = 0;
-}
-
-
-/*======================================================================
-	Function:		dmSetOutputs
-	Input:			column number
+	Function:		dmColumnPorts
+	Input:			port image (output), column number
 					bit pattern
 	Output:			none
-	Description:	Set row and column outputs so that the leds of the specified 
-					column represent the bit pattern (1 = led on).
+	Description:	Compute the row and column outputs so that the leds of the
+					specified column represent the bit pattern (1 = led on).
+					Column DISP_COLUMNS switches all columns off.
 ======================================================================*/
-inline void dmSetOutputs(uint8_t col, uint8_t pattern)
+static void dmColumnPorts(uint8_t* p, uint8_t col, uint8_t pattern)
 {
 	uint8_t i;
-	uint8_t p[3];
 
 	p[0] = 0;  p[1] = 0;  p[2] = 0;
 	for (i = 0; i < DISP_ROWS; i++) {
@@ -128,99 +179,254 @@ inline void dmSetOutputs(uint8_t col, uint8_t pattern)
 		p[1] ^= DISP_MASK_B;
 		p[2] ^= DISP_MASK_D;
 	#endif
+}
 
-	// set outputs
-	i = PORTA & ~DISP_MASK_A;
-	PORTA = i | p[0];
-	i = PORTB & ~DISP_MASK_B;
-	PORTB = i | p[1];
-	i = PORTD & ~DISP_MASK_D;
-	PORTD = i | p[2];
+
+/*======================================================================
+	Function:		dmInit
+	Input:			none
+	Output:			none
+	Description:	Initialize the hardware.
+======================================================================*/
+void dmInit(void)
+{
+	DISP_COL = 0;
+	DISP_FLAGS = 0;
+	dmColumnPorts(disp_blank, DISP_COLUMNS, 0);
+	dmClearDisplay();
+	display.scroll_mode = 0;
+	display.scroll_delay = 0;
+	#if LINK_NODES > 0
+		linkInit(display.memory);
+	#endif
 }
 
 
 /*======================================================================
-	Function:		dmDisplay
+	Function:		dmUpdatePorts
 	Input:			none
 	Output:			none
-	Description:	Switch to the next display column and display it on the led matrix.
-					Call this function periodically, e. g. within an interrupt routine.
+	Description:	Compute the port images of the display window after it
+					has changed and hand them to the display interrupt, which
+					shows them from the next first column on.
 ======================================================================*/
-void dmDisplay(void)
+void dmUpdatePorts(void)
 {
-	if (display.curr_col >= DISP_COLUMNS) {
-		display.curr_col = 0;
-	}
-	else {
-		display.curr_col++;
+	uint8_t (*image)[DISP_PORTS];
+	uint8_t col;
+
+	DISP_FLAGS &= ~(1<<DISP_FLIP);			// the interrupt keeps the image shown while the other one is written
+	image = disp_ports[(DISP_FLAGS & (1<<DISP_BUF)) ? 0 : 1];
+	for (col = 0; col < DISP_PHASES; col++) {
+		dmColumnPorts(image[col], col, (col < DISP_COLUMNS) ? display.memory[display.base + col] : 0);
 	}
-	dmSetOutputs(display.curr_col, display.memory[display.base + display.curr_col]);
+	DISP_FLAGS |= (1<<DISP_FLIP);
 }
 
 
 /*======================================================================
-	Function:		dmScroll
+	Function:		dmBlank
 	Input:			none
-	Output:			status
-	Description:	Scroll display by one step. Returns 1 if end of scrolling range has been reached.
-					Call this function periodically, e. g. within an interrupt routine.
+	Output:			none
+	Description:	Switch all leds off (until the next column is shown).
 ======================================================================*/
-uint8_t dmScroll(void)
+void dmBlank(void)
 {
-	uint8_t newmem[DISP_COLUMNS];
-	uint8_t x, y;
-	uint8_t l, r, t, b;
-	uint8_t live_neighbours;
+	PORTA = (PORTA & ~DISP_MASK_A) | disp_blank[0];
+	PORTB = (PORTB & ~DISP_MASK_B) | disp_blank[1];
+	PORTD = (PORTD & ~DISP_MASK_D) | disp_blank[2];
+}
 
-	static uint8_t samecnt = 0;
-	static uint16_t animcnt = 0;
-	uint8_t equal_cols = 0;
 
-	for (x = 0; x < DISP_COLUMNS; x++) {
+#ifdef __AVR__
+/*======================================================================
+	Function:		TIMER1_COMPA_vect
+	Input:			none
+	Output:			none
+	Description:	Display interrupt (timer 1 restarts automatically in CTC
+					mode): switch to the next column of the port image. The
+					state lives in GPIOR0 / GPIOR1, so the routine saves only
+					the four registers and SREG it uses.
+======================================================================*/
+ISR(TIMER1_COMPA_vect, ISR_NAKED)
+{
+	asm volatile (
+		"push	r24"						"\n\t"
+		"in		r24, __SREG__"				"\n\t"
+		"push	r24"						"\n\t"
+		"push	r25"						"\n\t"
+		"push	r30"						"\n\t"
+		"push	r31"						"\n\t"
+		"in		r30, %[col]"				"\n\t"	// offset of the column
+		"tst	r30"						"\n\t"
+		"brne	1f"							"\n\t"
+		"sbis	%[flags], %[flip]"			"\n\t"	// first column and a new image?
+		"rjmp	1f"							"\n\t"
+		"in		r24, %[flags]"				"\n\t"	// -> switch images
+		"ldi	r25, %[toggle]"				"\n\t"
+		"eor	r24, r25"					"\n\t"
+		"out	%[flags], r24"				"\n\t"
+	"1:"	"mov	r24, r30"				"\n\t"	// offset of the following column
+		"subi	r24, -%[size]"				"\n\t"
+		"cpi	r24, %[end]"				"\n\t"
+		"brlo	2f"							"\n\t"
+		"ldi	r24, 0"						"\n\t"
+	"2:"	"out	%[col], r24"			"\n\t"
+		"ldi	r31, 0"						"\n\t"
+		"sbic	%[flags], %[buf]"			"\n\t"
+		"subi	r30, -%[image]"				"\n\t"	// second image
+		"subi	r30, lo8(-(%[ports]))"		"\n\t"	// Z = &disp_ports[buf][0][0] + offset
+		"sbci	r31, hi8(-(%[ports]))"		"\n\t"
+		"in		r24, %[porta]"				"\n\t"
+		"andi	r24, %[mask_a]"				"\n\t"
+		"ld		r25, Z+"					"\n\t"
+		"or		r24, r25"					"\n\t"
+		"out	%[porta], r24"				"\n\t"
+		"in		r24, %[portb]"				"\n\t"
+		"andi	r24, %[mask_b]"				"\n\t"
+		"ld		r25, Z+"					"\n\t"
+		"or		r24, r25"					"\n\t"
+		"out	%[portb], r24"				"\n\t"
+		"in		r24, %[portd]"				"\n\t"
+		"andi	r24, %[mask_d]"				"\n\t"
+		"ld		r25, Z"						"\n\t"
+		"or		r24, r25"					"\n\t"
+		"out	%[portd], r24"				"\n\t"
+		"pop	r31"						"\n\t"
+		"pop	r30"						"\n\t"
+		"pop	r25"						"\n\t"
+		"pop	r24"						"\n\t"
+		"out	__SREG__, r24"				"\n\t"
+		"pop	r24"						"\n\t"
+		"reti"
+		:
+		: [col] "I" (_SFR_IO_ADDR(DISP_COL)), [flags] "I" (_SFR_IO_ADDR(DISP_FLAGS)),
+		  [flip] "I" (DISP_FLIP), [buf] "I" (DISP_BUF), [toggle] "M" ((1<<DISP_FLIP) | (1<<DISP_BUF)),
+		  [size] "M" (DISP_PORTS), [end] "M" (DISP_PHASES * DISP_PORTS),
+		  [image] "M" (DISP_PHASES * DISP_PORTS), [ports] "i" (disp_ports),
+		  [porta] "I" (_SFR_IO_ADDR(PORTA)), [mask_a] "M" (~DISP_MASK_A & 0xFF),
+		  [portb] "I" (_SFR_IO_ADDR(PORTB)), [mask_b] "M" (~DISP_MASK_B & 0xFF),
+		  [portd] "I" (_SFR_IO_ADDR(PORTD)), [mask_d] "M" (~DISP_MASK_D & 0xFF)
+	);
+}
 
-		l = (x == 0) ? (DISP_COLUMNS - 1) : (x - 1);
-		r = (x == (DISP_COLUMNS - 1)) ? 0 : (x + 1);
 
-		newmem[x] = 0;
+/*======================================================================
+	Function:		TIMER1_COMPB_vect
+	Input:			none
+	Output:			none
+	Description:	Dimming: switch the display off for the rest of the
+					column slot (OCR1B, see SetColumnFreq). As the display
+					is dark when TIMER1_COMPA_vect switches the ports one
+					by one, the next column shows no trace of the previous
+					one.
+======================================================================*/
+ISR(TIMER1_COMPB_vect, ISR_NAKED)
+{
+	asm volatile (
+		"push	r24"						"\n\t"
+		"in		r24, __SREG__"				"\n\t"
+		"push	r24"						"\n\t"
+		"push	r25"						"\n\t"
+		"in		r24, %[porta]"				"\n\t"
+		"andi	r24, %[mask_a]"				"\n\t"
+		"lds	r25, %[blank]"				"\n\t"
+		"or		r24, r25"					"\n\t"
+		"out	%[porta], r24"				"\n\t"
+		"in		r24, %[portb]"				"\n\t"
+		"andi	r24, %[mask_b]"				"\n\t"
+		"lds	r25, %[blank]+1"			"\n\t"
+		"or		r24, r25"					"\n\t"
+		"out	%[portb], r24"				"\n\t"
+		"in		r24, %[portd]"				"\n\t"
+		"andi	r24, %[mask_d]"				"\n\t"
+		"lds	r25, %[blank]+2"			"\n\t"
+		"or		r24, r25"					"\n\t"
+		"out	%[portd], r24"				"\n\t"
+		"pop	r25"						"\n\t"
+		"pop	r24"						"\n\t"
+		"out	__SREG__, r24"				"\n\t"
+		"pop	r24"						"\n\t"
+		"reti"
+		:
+		: [blank] "i" (disp_blank),
+		  [porta] "I" (_SFR_IO_ADDR(PORTA)), [mask_a] "M" (~DISP_MASK_A & 0xFF),
+		  [portb] "I" (_SFR_IO_ADDR(PORTB)), [mask_b] "M" (~DISP_MASK_B & 0xFF),
+		  [portd] "I" (_SFR_IO_ADDR(PORTD)), [mask_d] "M" (~DISP_MASK_D & 0xFF)
+	);
+}
 
-		for (y = 0; y < DISP_ROWS; y++) {
+#else
+/*======================================================================
+	Function:		dmDisplay
+	Input:			none
+	Output:			none
+	Description:	C version of the display interrupt for the host
+					(lifeemu), same state and port images.
+======================================================================*/
+void dmDisplay(void)
+{
+	uint8_t col = DISP_COL;
+	const uint8_t* p;
 
-			t = (y == 0) ? (DISP_ROWS - 1) : (y - 1);
-			b = (y == (DISP_ROWS - 1)) ? 0 : (y + 1);
+	if (col == 0 && (DISP_FLAGS & (1<<DISP_FLIP))) {
+		DISP_FLAGS ^= (1<<DISP_FLIP) | (1<<DISP_BUF);
+	}
+	DISP_COL = (col + DISP_PORTS < DISP_PHASES * DISP_PORTS) ? (col + DISP_PORTS) : 0;
+	p = &disp_ports[DISP_FLAGS & (1<<DISP_BUF)][0][0] + col;
+	PORTA = (PORTA & ~DISP_MASK_A) | p[0];
+	PORTB = (PORTB & ~DISP_MASK_B) | p[1];
+	PORTD = (PORTD & ~DISP_MASK_D) | p[2];
+}
 
-			live_neighbours =
-				((display.memory[l] & _BV(t)) > 0) +
-				((display.memory[l] & _BV(y)) > 0) +
-				((display.memory[l] & _BV(b)) > 0) +
-				((display.memory[x] & _BV(t)) > 0) +
-				((display.memory[x] & _BV(b)) > 0) +
-				((display.memory[r] & _BV(t)) > 0) +
-				((display.memory[r] & _BV(y)) > 0) +
-				((display.memory[r] & _BV(b)) > 0);
 
-			if (((live_neighbours == 2) && (display.memory[x] & _BV(y)))
-					|| (live_neighbours == 3))
-				newmem[x] |= _BV(y);
+ISR(TIMER1_COMPA_vect)
+{
+	dmDisplay();
+}
 
-		}
-	}
 
-	for (x = 0; x < DISP_COLUMNS; x++) {
+ISR(TIMER1_COMPB_vect)
+{
+	dmBlank();
+}
+#endif
+
+
+/*======================================================================
+	Function:		dmScroll
+	Input:			none
+	Output:			status
+	Description:	Scroll display by one step. Returns 1 if end of scrolling range has been reached.
+					Call this function periodically, e. g. within an interrupt routine.
+======================================================================*/
+uint8_t dmScroll(void)
+{
+	uint8_t newmem[DISP_MAX];
+	uint8_t x;
+	uint8_t equal_cols = 0;
+
+	#if LIFE_GENERATIONS > 1
+		lifeStepBlocked(newmem, display.memory, DISP_MAX, LIFE_GENERATIONS);	// fast forward
+	#else
+		lifeStep(newmem, display.memory, DISP_MAX);	// see life.h for the kernel selection
+	#endif
+
+	for (x = DISP_BASE; x < DISP_BASE + DISP_COLUMNS; x++) {	// halo columns do not count
 		if (display.memory[x] == newmem[x])
 			equal_cols++;
+	}
+	for (x = 0; x < DISP_MAX; x++) {
 		display.memory[x] = newmem[x];
 	}
-	if (equal_cols == DISP_COLUMNS) {
-		if (++samecnt == 32) {
-			samecnt = 0;
-			animcnt = 0;
+	dmUpdatePorts();
+	#if LINK_NODES > 0
+		link.changed = (equal_cols != DISP_COLUMNS);	// the master decides on reseeds (see link.h)
+	#else
+		if (lifeReseedDue(equal_cols == DISP_COLUMNS)) {
 			dmWakeUp();
 		}
-	}
-	if (++animcnt == 1024) {
-		animcnt = 0;
-		dmWakeUp();
-	}
+	#endif
 	return 0;
 }
 
@@ -235,21 +441,249 @@ void dmClearDisplay(void)
 {
 	uint8_t i;
 
-	display.base  = 0;
+	display.base  = DISP_BASE;
 	display.cursor = 0;
-	for (i = 0; i < DISP_COLUMNS; i++) {
+	for (i = 0; i < DISP_MAX; i++) {
 		display.memory[i] = 0;
 	}
+	#if LOOKAHEAD_FRAMES > 0
+		frame_head = 0;
+		frame_tail = 0;
+		frame_age = 0;
+	#endif
+	dmUpdatePorts();
 }
 
-void dmWakeUp()
+/*======================================================================
+	Function:		dmShowFrame
+	Input:			frame (DISP_MAX bytes)
+	Output:			none
+	Description:	Replace the world by a frame from outside (streaming
+					mode). The display switches to it at column 0.
+======================================================================*/
+void dmShowFrame(const uint8_t* frame)
 {
 	uint8_t i;
 
-	display.base  = 0;
+	for (i = 0; i < DISP_MAX; i++) {
+		display.memory[i] = frame[i];
+	}
+	display.base = DISP_BASE;
+	dmUpdatePorts();
+}
+
+
+/*======================================================================
+	Function:		dmRandomize
+	Input:			frame (DISP_MAX bytes)
+	Output:			none
+	Description:	Fill a frame with a random soup.
+======================================================================*/
+static void dmRandomize(uint8_t* frame)
+{
+	uint8_t i;
+
+	for (i = 0; i < DISP_MAX; i++) {
+		frame[i] = rand() % 0x80;
+	}
+}
+
+
+static uint8_t dmReadBit(bitstream_t* s)
+{
+	uint8_t bit;
+
+	if (s->mask == 0) {
+		s->data = pgm_read_byte(s->next++);
+		s->mask = 1;
+	}
+	bit = s->data & s->mask;
+	s->mask <<= 1;
+	return bit;
+}
+
+
+/*======================================================================
+	Function:		dmDecodePattern
+	Input:			frame (DISP_MAX bytes), pattern in flash, first column
+	Output:			address of the following pattern
+	Description:	Decode a pattern of the library (format see host/patenc.c)
+					straight from flash into a frame, starting at the given
+					column and centred vertically. The columns are or-ed into
+					the frame, so several patterns can be combined into one
+					scene; columns beyond the end of the frame are dropped.
+======================================================================*/
+const uint8_t* dmDecodePattern(uint8_t* frame, const uint8_t* pattern, uint8_t offset)
+{
+	bitstream_t s;
+	uint8_t header = pgm_read_byte(pattern);
+	uint8_t width = (header >> 3) + 1;
+	uint8_t height = (header & 7) + 1;
+	uint8_t top = 1 << ((DISP_ROWS - height) / 2);	// bit of the first pattern row
+	uint8_t col = 0, bit, i;
+
+	s.next = pattern + 1;
+	s.mask = 0;
+	while (width--) {
+		if (!dmReadBit(&s)) {				// 0 + height bits: column
+			col = 0;
+			bit = top;
+			for (i = 0; i < height; i++) {
+				if (dmReadBit(&s)) {
+					col |= bit;
+				}
+				bit <<= 1;
+			}
+		}
+		else if (!dmReadBit(&s)) {			// 10: empty column
+			col = 0;
+		}									// 11: same as the previous column
+		if (offset < DISP_MAX) {
+			frame[offset++] |= col;
+		}
+	}
+	return s.next;
+}
+
+
+/*======================================================================
+	Function:		dmSeed
+	Input:			frame (DISP_MAX bytes)
+	Output:			none
+	Description:	Fill a frame with a new world. With PATTERN_LIBRARY the
+					patterns of the library are seeded in turn (centred,
+					patterns wider than the display memory are skipped),
+					followed by a random soup; otherwise a random soup.
+======================================================================*/
+static void dmSeed(uint8_t* frame)
+{
+	#if PATTERN_LIBRARY
+		uint8_t width, i;
+
+		while (pattern_index < PATTERN_COUNT) {
+			width = (pgm_read_byte(pattern_next) >> 3) + 1;
+			pattern_index++;
+			if (width <= DISP_MAX) {
+				for (i = 0; i < DISP_MAX; i++) {
+					frame[i] = 0;
+				}
+				pattern_next = dmDecodePattern(frame, pattern_next, (DISP_MAX - width) / 2);
+				pattern_seeded = 1;
+				return;
+			}
+			pattern_next = dmDecodePattern(frame, pattern_next, DISP_MAX);	// skip it
+		}
+		pattern_index = 0;
+		pattern_next = patterns;
+		pattern_seeded = 0;
+	#endif
+	dmRandomize(frame);
+}
+
+
+void dmWakeUp()
+{
+	display.base  = DISP_BASE;
 	display.cursor = 0;
 
-	for (i = 0; i < DISP_COLUMNS; i++) {
-		display.memory[i] = rand() % 0x80;
+	dmSeed(display.memory);
+	#if LIFE_RULE_TABLE
+		lifeNextRule();
+	#endif
+	#if LOOKAHEAD_FRAMES > 0
+		frame_head = 0;
+		frame_tail = 0;
+		frame_age = 0;
+	#endif
+	dmUpdatePorts();
+}
+
+
+#if LOOKAHEAD_FRAMES > 0
+/*======================================================================
+	Function:		dmProduce
+	Input:			none
+	Output:			1 if a frame has been computed, 0 if the ring is full
+	Description:	Compute the generation following the newest frame of the
+					ring. Call this function from the main loop whenever
+					there is nothing else to do.
+					As the producer runs ahead of the display, a still life
+					or a period 2 oscillator is replaced by a new soup before
+					the repeating frames are displayed.
+======================================================================*/
+uint8_t dmProduce(void)
+{
+	uint8_t next = (frame_head == LOOKAHEAD_FRAMES - 1) ? 0 : (frame_head + 1);
+	uint8_t prev = (frame_head == 0) ? (LOOKAHEAD_FRAMES - 1) : (frame_head - 1);
+	uint8_t* src = display.memory + frame_head * DISP_MAX;
+	uint8_t* dst = display.memory + next * DISP_MAX;
+	uint8_t* before = display.memory + prev * DISP_MAX;	// predecessor of src (if frame_age > 0)
+	uint8_t still = 1, cycle = (frame_age > 0);
+	uint8_t x;
+
+	if (next == frame_tail) {
+		return 0;							// ring is full
+	}
+
+	#if LIFE_GENERATIONS > 1
+		lifeStepBlocked(dst, src, DISP_MAX, LIFE_GENERATIONS);
+	#else
+		lifeStep(dst, src, DISP_MAX);
+	#endif
+
+	for (x = 0; x < DISP_MAX; x++) {
+		if (dst[x] != src[x])
+			still = 0;
+		if (dst[x] != before[x])
+			cycle = 0;
+	}
+	#if PATTERN_LIBRARY
+		if (pattern_seeded) {				// keep oscillators of the library like dmScroll() does
+			cycle = 0;
+			still = lifeReseedDue(still);
+		}
+		else {
+			still = still || lifeReseedDue(0);
+		}
+	#else
+		still = still || lifeReseedDue(0);
+	#endif
+	if (still || cycle) {
+		dmSeed(dst);
+		lifeResetCounters();
+		#if LIFE_RULE_TABLE
+			lifeNextRule();
+		#endif
+		frame_age = 0;
 	}
+	else {
+		frame_age++;
+	}
+	frame_head = next;						// publish the frame
+	return 1;
 }
+
+
+/*======================================================================
+	Function:		dmNextFrame
+	Input:			none
+	Output:			none
+	Description:	Display the next frame of the ring. Call this function
+					from the system timer interrupt instead of dmScroll().
+======================================================================*/
+void dmNextFrame(void)
+{
+	uint8_t tail = frame_tail;
+
+	if (tail == frame_head) {				// producer is late -> keep the current frame
+		if (frames_late != 0xFF) {
+			frames_late++;
+		}
+		return;
+	}
+	tail = (tail == LOOKAHEAD_FRAMES - 1) ? 0 : (tail + 1);
+	display.base = tail * DISP_MAX;
+	frame_tail = tail;
+	dmUpdatePorts();
+}
+#endif
@@ -41,7 +41,17 @@ Disclaimer:			This software is provided by the copyright holder "as is" and any
 //#define DOT_MATRIX_TYPE		HDSP5403
 
 // display memory
-#define DISP_MAX			5			// size of display memory in bytes (1 byte = 1 column, range 5..240)
+#if LINK_NODES > 0
+	#define DISP_MAX		(DISP_COLUMNS + 2)	// own part of a shared world plus the edge columns of both neighbours
+	#define DISP_BASE		1					// first own column
+#else
+	#define DISP_MAX		5			// size of display memory in bytes (1 byte = 1 column, range 5..240)
+	#define DISP_BASE		0			// first displayed column
+#endif
+
+// pattern library (patterns.h, generated by host/patenc): the header byte of a pattern
+// holds (width - 1) << 3 | (height - 1), so a pattern has at most 32 columns
+#define DISP_PATTERN_COLS	32			// do not change
 
 // scrolling directions
 #define FORWARD				0			// text moves from right to left
@@ -126,18 +136,28 @@ Disclaimer:			This software is provided by the copyright holder "as is" and any
 /**************
  * prototypes *
  **************/
+#ifndef __ASSEMBLER__
 void dmInit(void);
-void dmDisplay(void);
+#ifndef __AVR__
+	void dmDisplay(void);					// the AVR uses the display interrupt of dot_matrix.c
+#endif
+void dmUpdatePorts(void);
+void dmBlank(void);
 uint8_t dmScroll(void);
 void dmSetScrolling(uint8_t inc, uint8_t dir, uint8_t delay);
 void dmClearDisplay(void);
 void dmDisplayImage(const uint8_t* image);
 void dmWakeUp();
+uint8_t dmProduce(void);
+void dmNextFrame(void);
+void dmShowFrame(const uint8_t* frame);
+const uint8_t* dmDecodePattern(uint8_t* frame, const uint8_t* pattern, uint8_t offset);
 void dmPrintChar(uint8_t ch);
 
 // The following function was commented out to save flash memory.
 // Uncomment it if you want to use it.
 //void dmPrintString(const char* st);
+#endif /* __ASSEMBLER__ */
 
 
 
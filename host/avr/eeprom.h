@@ -0,0 +1,36 @@
+/*
+ * avr/eeprom.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Host replacement of <avr/eeprom.h> for the emulator. EEPROM
+					variables live in RAM, a write costs the programming time
+					of the real EEPROM.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+
+**********************************************************************************/
+
+
+#ifndef HOST_EEPROM_H_
+#define HOST_EEPROM_H_
+
+#include <inttypes.h>
+
+void emuEepromWrite(uint8_t bytes);
+
+#define EEMEM
+#define eeprom_read_byte(addr)			(*(const uint8_t*)(addr))
+#define eeprom_read_word(addr)			(*(const uint16_t*)(addr))
+#define eeprom_read_dword(addr)			(*(const uint32_t*)(addr))
+#define eeprom_write_byte(addr, val)	(emuEepromWrite(1), *(uint8_t*)(addr) = (val))
+#define eeprom_write_word(addr, val)	(emuEepromWrite(2), *(uint16_t*)(addr) = (val))
+#define eeprom_update_byte(addr, val)	eeprom_write_byte(addr, val)
+#define eeprom_update_word(addr, val)	eeprom_write_word(addr, val)
+#define eeprom_update_dword(addr, val)	(emuEepromWrite(4), *(uint32_t*)(addr) = (val))
+
+
+#endif /* HOST_EEPROM_H_ */
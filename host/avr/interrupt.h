@@ -0,0 +1,31 @@
+/*
+ * avr/interrupt.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Host replacement of <avr/interrupt.h> for the emulator. An
+					interrupt service routine is a plain function which the
+					emulator calls when its flag is set and interrupts are
+					enabled (I bit of SREG).
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+
+**********************************************************************************/
+
+
+#ifndef HOST_INTERRUPT_H_
+#define HOST_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector, ...)		void vector(void); void vector(void)
+#define ISR_NAKED
+#define sei()					(SREG |= 0x80)
+#define cli()					(SREG &= ~0x80)
+#define reti()					return
+
+
+#endif /* HOST_INTERRUPT_H_ */
@@ -0,0 +1,45 @@
+/*
+ * avr/io.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Host replacement of <avr/io.h> for the emulator (lifeemu.c).
+					Every I/O register access goes through emuSfr(), which
+					brings the emulated timers up to the current virtual time.
+					The register names come from the iotn4313.h of the firmware.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+
+**********************************************************************************/
+
+
+#ifndef _AVR_IO_H_
+#define _AVR_IO_H_
+
+#include <inttypes.h>
+
+volatile uint8_t* emuSfr(uint16_t addr);	// data space address (I/O address + 0x20)
+
+#define __SFR_OFFSET			0x20
+#define _SFR_IO8(a)				(*emuSfr((a) + __SFR_OFFSET))
+#define _SFR_IO16(a)			(*(volatile uint16_t*)emuSfr((a) + __SFR_OFFSET))
+#define _SFR_MEM8(a)			(*emuSfr(a))
+#define _SFR_MEM16(a)			(*(volatile uint16_t*)emuSfr(a))
+#define _VECTOR(n)				__vector_ ## n
+#define _BV(bit)				(1 << (bit))
+
+#define SREG					_SFR_IO8(0x3F)
+
+#include "../../iotn4313.h"
+
+// <avr/fuse.h>
+typedef struct {
+	uint8_t low, high, extended;
+} __fuse_t;
+#define FUSES					__fuse_t __fuse
+
+
+#endif /* _AVR_IO_H_ */
@@ -0,0 +1,28 @@
+/*
+ * avr/pgmspace.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Host replacement of <avr/pgmspace.h>. The host has a single
+					address space, so flash data is just constant data.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+
+**********************************************************************************/
+
+
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#include <inttypes.h>
+
+#define PROGMEM
+#define PSTR(s)					(s)
+#define pgm_read_byte(addr)		(*(const uint8_t*)(addr))
+#define pgm_read_word(addr)		(*(const uint16_t*)(addr))
+
+
+#endif /* HOST_PGMSPACE_H_ */
@@ -0,0 +1,35 @@
+/*
+ * avr/sleep.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Host replacement of <avr/sleep.h> for the emulator. Sleeping
+					hands control to the scheduler, which advances the virtual
+					time to the next interrupt.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+
+**********************************************************************************/
+
+
+#ifndef HOST_SLEEP_H_
+#define HOST_SLEEP_H_
+
+#define SLEEP_MODE_IDLE			0
+#define SLEEP_MODE_PWR_DOWN		1
+#define SLEEP_MODE_STANDBY		2
+
+void emuSetSleepMode(uint8_t mode);
+void emuSleep(void);
+
+#define set_sleep_mode(mode)	emuSetSleepMode(mode)
+#define sleep_mode()			emuSleep()
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu()				emuSleep()
+
+
+#endif /* HOST_SLEEP_H_ */
@@ -0,0 +1,25 @@
+/*
+ * avr/wdt.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Host replacement of <avr/wdt.h> for the emulator. wdr restarts
+					the current watchdog period.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+
+**********************************************************************************/
+
+
+#ifndef HOST_WDT_H_
+#define HOST_WDT_H_
+
+void emuWdtReset(void);
+
+#define wdt_reset()				emuWdtReset()
+
+
+#endif /* HOST_WDT_H_ */
@@ -0,0 +1,360 @@
+/*
+ * hacklace_life.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		libhacklace-life.so (see hacklace_life.h). The generations
+					are computed by the kernel of the firmware (lifeStep or
+					lifeStepBlocked of life.c, selected in life.h), the
+					reseeding follows lifeReseedDue() with counters per world.
+					Besides, every world looks for the cycle it has entered:
+					the frames since the last reseed are kept (up to
+					LIFE_MAX_GENS) and a hash table finds the first repeated
+					frame.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dot_matrix.h"
+#include "life.h"
+#include "kernels.h"
+#include "hacklace_life.h"
+
+
+#if LIFE_KERNEL == LIFE_KERNEL_ASM
+	#undef lifeStep
+	#define lifeStep		lifeStepAsmModel	// C model of life_asm.S (kernels.c)
+#endif
+
+
+/*************
+ * constants *
+ *************/
+
+#define MAX_COLS		240				// DISP_MAX limit
+#define HISTORY			LIFE_MAX_GENS	// frames searched for a cycle
+#define HASH_SIZE		4096			// > 2 * HISTORY, power of 2
+
+#define HL_EXPORT		__attribute__((visibility("default")))
+
+
+/*********
+ * types *
+ *********/
+
+struct hl_world {
+	uint8_t buf[MAX_COLS];				// current generation (hl_buffer)
+	uint8_t last[MAX_COLS];				// buf after the last hl_step (detects writes by the caller)
+	uint32_t cols;
+	unsigned rng;						// state of rand_r
+	uint8_t samecnt;					// counters of lifeReseedDue()
+	uint16_t animcnt;
+	uint64_t generation, reseeds, still_reseeds;
+	uint32_t age;
+	uint32_t transient, period;
+	uint8_t searching;					// cycle search running
+	uint32_t frames;					// frames in history
+	uint16_t hash[HASH_SIZE];			// frame number + 1, 0 = empty
+	uint8_t* history;					// HISTORY frames of cols bytes
+};
+
+
+/*************
+ * functions *
+ *************/
+
+static uint32_t frameHash(const uint8_t* frame, uint32_t cols)
+{
+	uint32_t h = 2166136261UL;
+	uint32_t x;
+
+	for (x = 0; x < cols; x++) {
+		h = (h ^ frame[x]) * 16777619UL;
+	}
+	return h;
+}
+
+
+/*======================================================================
+	Function:		record
+	Input:			world
+	Output:			none
+	Description:	Add the current generation to the cycle search. The
+					first frame which is already in the history closes the
+					cycle: transient = its first occurrence, period = the
+					distance. The search gives up after HISTORY frames.
+======================================================================*/
+static void record(hl_world_t* w)
+{
+	uint32_t h = frameHash(w->buf, w->cols) & (HASH_SIZE - 1);
+
+	if (!w->searching) {
+		return;
+	}
+	while (w->hash[h]) {
+		uint32_t f = w->hash[h] - 1;
+
+		if (!memcmp(w->history + (size_t)f * w->cols, w->buf, w->cols)) {
+			w->transient = f;
+			w->period = w->frames - f;
+			w->searching = 0;
+			return;
+		}
+		h = (h + 1) & (HASH_SIZE - 1);
+	}
+	if (w->frames == HISTORY) {
+		w->searching = 0;				// no cycle within the horizon
+		return;
+	}
+	memcpy(w->history + (size_t)w->frames * w->cols, w->buf, w->cols);
+	w->hash[h] = ++w->frames;
+}
+
+
+// restart the cycle search with the current generation as frame 0
+static void restartSearch(hl_world_t* w)
+{
+	memset(w->hash, 0, sizeof(w->hash));
+	w->frames = 0;
+	w->transient = 0;
+	w->period = 0;
+	w->searching = 1;
+	w->age = 0;
+	record(w);
+}
+
+
+// same as lifeReseedDue(), 2 = after a still life, 1 = after LIFE_MAX_GENS
+static uint8_t reseedDue(hl_world_t* w, uint8_t still)
+{
+	uint8_t reseed = 0;
+
+	if (still) {
+		if (++w->samecnt == LIFE_STILL_GENS) {
+			w->samecnt = 0;
+			w->animcnt = 0;
+			reseed = 2;
+		}
+	}
+	if (++w->animcnt == LIFE_MAX_GENS) {
+		w->animcnt = 0;
+		if (!reseed) {
+			reseed = 1;
+		}
+	}
+	return reseed;
+}
+
+
+HL_EXPORT uint32_t hl_version(void)
+{
+	return HL_API_VERSION;
+}
+
+
+HL_EXPORT uint32_t hl_rows(void)
+{
+	return DISP_ROWS;
+}
+
+
+HL_EXPORT uint32_t hl_generations_per_step(void)
+{
+	return LIFE_GENERATIONS;
+}
+
+
+/*======================================================================
+	Function:		hl_rule
+	Input:			birth and survival mask (output, bit n = n neighbours)
+	Output:			none
+	Description:	Rule of the kernel (with LIFE_RULE_TABLE the current
+					rule, which changes with every reseed of any world).
+======================================================================*/
+HL_EXPORT void hl_rule(uint16_t* birth, uint16_t* survive)
+{
+	*birth = LIFE_RULE_BIRTH;
+	*survive = LIFE_RULE_SURVIVE;
+}
+
+
+/*======================================================================
+	Function:		hl_create
+	Input:			columns (3 .. 240), seed of the random soups
+	Output:			world or NULL
+	Description:	Create a world with a random soup like dmWakeUp().
+======================================================================*/
+HL_EXPORT hl_world_t* hl_create(uint32_t columns, uint32_t seed)
+{
+	hl_world_t* w;
+
+	if (columns < 3 || columns > MAX_COLS || !(w = calloc(1, sizeof(*w)))) {
+		return NULL;
+	}
+	if (!(w->history = malloc((size_t)HISTORY * columns))) {
+		free(w);
+		return NULL;
+	}
+	w->cols = columns;
+	w->rng = seed;
+	hl_seed(w);
+	w->reseeds = 0;						// the first soup is not a reseed
+	return w;
+}
+
+
+HL_EXPORT void hl_destroy(hl_world_t* w)
+{
+	if (w) {
+		free(w->history);
+		free(w);
+	}
+}
+
+
+/*======================================================================
+	Function:		hl_buffer
+	Input:			world
+	Output:			current generation (hl_columns bytes, bit y = row y)
+	Description:	The buffer may be read and written in place at any
+					time between calls. A change restarts the cycle search.
+======================================================================*/
+HL_EXPORT uint8_t* hl_buffer(hl_world_t* w)
+{
+	return w->buf;
+}
+
+
+HL_EXPORT uint32_t hl_columns(const hl_world_t* w)
+{
+	return w->cols;
+}
+
+
+/*======================================================================
+	Function:		hl_seed
+	Input:			world
+	Output:			none
+	Description:	Replace the world by a random soup like dmWakeUp().
+					As there, the reseed counters are left alone.
+======================================================================*/
+HL_EXPORT void hl_seed(hl_world_t* w)
+{
+	uint32_t x;
+
+	for (x = 0; x < w->cols; x++) {
+		w->buf[x] = rand_r(&w->rng) % (1 << DISP_ROWS);
+	}
+	#if LIFE_RULE_TABLE
+		lifeNextRule();
+	#endif
+	w->reseeds++;
+	memcpy(w->last, w->buf, w->cols);
+	restartSearch(w);
+}
+
+
+/*======================================================================
+	Function:		hl_step
+	Input:			world, number of scrolling steps (hl_generations_per_step
+					generations each), flags (HL_RESEED)
+	Output:			number of reseeds
+	Description:	Advance the world like dmScroll(). A step is still if
+					the displayed columns (DISP_BASE .. DISP_BASE +
+					DISP_COLUMNS - 1) did not change. With HL_RESEED the
+					world is replaced like in the firmware, otherwise it
+					just evolves.
+======================================================================*/
+HL_EXPORT uint64_t hl_step(hl_world_t* w, uint64_t steps, uint32_t flags)
+{
+	uint8_t next[MAX_COLS];
+	uint32_t x, shown = DISP_BASE + DISP_COLUMNS;
+	uint64_t s, reseeds = 0;
+	uint8_t equal, reseed;
+
+	if (shown > w->cols) {
+		shown = w->cols;
+	}
+	if (memcmp(w->buf, w->last, w->cols)) {
+		restartSearch(w);				// written by the caller
+	}
+	for (s = 0; s < steps; s++) {
+		#if LIFE_GENERATIONS > 1
+			lifeStepBlocked(next, w->buf, w->cols, LIFE_GENERATIONS);
+		#else
+			lifeStep(next, w->buf, w->cols);
+		#endif
+		for (x = DISP_BASE, equal = 1; x < shown; x++) {
+			if (w->buf[x] != next[x]) {
+				equal = 0;
+				break;
+			}
+		}
+		memcpy(w->buf, next, w->cols);
+		w->generation += LIFE_GENERATIONS;
+		w->age += LIFE_GENERATIONS;
+		if ((flags & HL_RESEED) && (reseed = reseedDue(w, equal))) {
+			if (reseed == 2) {
+				w->still_reseeds++;
+			}
+			hl_seed(w);
+			reseeds++;
+		}
+		else {
+			record(w);
+		}
+	}
+	memcpy(w->last, w->buf, w->cols);
+	return reseeds;
+}
+
+
+/*======================================================================
+	Function:		hl_stats
+	Input:			world, statistics (output), size of the statistics
+					structure of the caller (sizeof(hl_stats_t))
+	Output:			number of bytes filled in
+	Description:	Callers built against an older header get the fields
+					they know about.
+======================================================================*/
+HL_EXPORT size_t hl_stats(const hl_world_t* w, hl_stats_t* stats, size_t size)
+{
+	hl_stats_t s;
+	uint32_t x;
+
+	memset(&s, 0, sizeof(s));
+	s.generation = w->generation;
+	s.reseeds = w->reseeds;
+	s.still_reseeds = w->still_reseeds;
+	s.age = w->age;
+	s.still = w->samecnt;
+	for (x = 0; x < w->cols; x++) {
+		s.population += __builtin_popcount(w->buf[x]);
+	}
+	s.transient = w->transient * LIFE_GENERATIONS;
+	s.period = w->period * LIFE_GENERATIONS;
+	if (size > sizeof(s)) {
+		size = sizeof(s);
+	}
+	memcpy(stats, &s, size);
+	return size;
+}
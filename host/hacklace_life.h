@@ -0,0 +1,98 @@
+/*
+ * hacklace_life.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		C API of libhacklace-life.so, the generation loop of the
+					firmware (dmScroll: kernel selected in life.h, still life
+					detection, reseeding after LIFE_STILL_GENS still or
+					LIFE_MAX_GENS generations) as a shared library for
+					analysis scripts. A world is a torus of 'columns' bytes in
+					the layout of display.memory (bit y = row y); its buffer
+					stays at the same address for the lifetime of the world,
+					so it can be read and written in place, e.g. by numpy via
+					ctypes. Worlds are independent of each other, but a
+					single world must not be used by two threads at once.
+					The API is stable: functions are only added, and the
+					statistics grow at the end of hl_stats_t.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+
+#ifndef HACKLACE_LIFE_H_
+#define HACKLACE_LIFE_H_
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*************
+ * constants *
+ *************/
+
+#define HL_API_VERSION		1
+
+// flags of hl_step
+#define HL_RESEED			0x01		// replace still lifes and old worlds like the firmware
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct hl_world hl_world_t;
+
+typedef struct {
+	uint64_t generation;				// generations computed since hl_create
+	uint64_t reseeds;					// new worlds (by hl_step or hl_seed)
+	uint64_t still_reseeds;				// of these: after LIFE_STILL_GENS still generations
+	uint32_t age;						// generations since the last reseed
+	uint32_t still;						// still life counter of the reseeding (samecnt of life.c)
+	uint32_t population;				// live cells
+	uint32_t transient;					// generations from the last reseed to the cycle
+	uint32_t period;					// length of the cycle, 0 = not found (yet)
+} hl_stats_t;
+
+
+/**************
+ * prototypes *
+ **************/
+uint32_t hl_version(void);
+uint32_t hl_rows(void);
+uint32_t hl_generations_per_step(void);
+void hl_rule(uint16_t* birth, uint16_t* survive);
+hl_world_t* hl_create(uint32_t columns, uint32_t seed);
+void hl_destroy(hl_world_t* w);
+uint8_t* hl_buffer(hl_world_t* w);
+uint32_t hl_columns(const hl_world_t* w);
+void hl_seed(hl_world_t* w);
+uint64_t hl_step(hl_world_t* w, uint64_t steps, uint32_t flags);
+size_t hl_stats(const hl_world_t* w, hl_stats_t* stats, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HACKLACE_LIFE_H_ */
@@ -0,0 +1,218 @@
+/*
+ * kernels.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Generation kernels available to the host side tools
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <string.h>
+#include "dot_matrix.h"
+#include "life.h"
+#include "kernels.h"
+
+
+/********************
+ * global variables *
+ ********************/
+
+const kernel_t kernels[] = {
+	{"ref",			lifeStepRef,		1},
+	{"asm-model",	lifeStepAsmModel,	1},
+	{"lut",			lifeStepLut,		1},
+	{"lut2",		lifeStepLut2,		1},
+	{"rows",		lifeStepRows,		1},
+	{"blocked1",	lifeStepBlocked1,	1},
+	{"blocked4",	lifeStepBlocked4,	4},
+	{NULL,			NULL,				0}
+};
+
+
+static uint8_t lut2[1 << 12];			// next state of two cells, see lifeStepLut2 (built by buildLut2)
+
+
+/*************
+ * functions *
+ *************/
+
+// row above / row below of every cell of a column (see ROWS in life_asm.S)
+static inline void rows(uint8_t col, uint8_t* r24, uint8_t* r25)
+{
+	*r24 = (uint8_t)(col << 1);
+	if (col & (1 << (DISP_ROWS - 1))) {
+		*r24 |= 0x01;
+	}
+	*r24 &= (1 << DISP_ROWS) - 1;
+	*r25 = col >> 1;
+	if (col & 1) {
+		*r25 |= 1 << (DISP_ROWS - 1);
+	}
+}
+
+
+// above + self + below (see VSUM3 in life_asm.S)
+static inline void vsum3(uint8_t col, uint8_t* s0, uint8_t* s1)
+{
+	uint8_t r24, r25;
+
+	rows(col, &r24, &r25);
+	*s1 = r24 & r25;
+	r24 ^= r25;
+	*s0 = r24 ^ col;
+	r24 &= col;
+	*s1 |= r24;
+}
+
+
+/*======================================================================
+	Function:		lifeStepAsmModel
+	Input:			see lifeStepAsm
+	Output:			none
+	Description:	Instruction by instruction C model of lifeStepAsm
+					(life_asm.S) so that its adder network can be checked
+					on the host. Variables are named after the registers.
+======================================================================*/
+void lifeStepAsmModel(uint8_t* dst, const uint8_t* src, uint8_t cols)
+{
+	uint8_t r0, r16, r17, r18, r19, r21, r22, r23, r24, r25;
+	uint8_t r20 = cols;
+	const uint8_t* z = src;
+
+	r18 = src[cols - 1];
+	r21 = *z++;
+	r19 = r21;
+	do {
+		r22 = r21;
+		if (r20 != 1) {
+			r22 = *z++;
+		}
+		vsum3(r18, &r0, &r23);
+		vsum3(r22, &r16, &r17);
+
+		r25 = r0 & r16;
+		r0 ^= r16;
+		r16 = r23 ^ r17;
+		r23 &= r17;
+		r17 = r16 & r25;
+		r23 |= r17;
+		r16 ^= r25;
+
+		rows(r19, &r24, &r25);
+		r17 = r24 & r25;
+		r24 ^= r25;
+		r25 = r0 & r24;
+		r0 ^= r24;
+		r24 = r16 & r17;
+		r16 ^= r17;
+		r17 = r16 & r25;
+		r24 |= r17;
+		r16 ^= r25;
+		r23 ^= r24;
+
+		r0 |= r19;
+		r0 &= r16;
+		r23 = ~r23;
+		r0 &= r23;
+		*dst++ = r0;
+
+		r18 = r19;
+		r19 = r22;
+	} while (--r20);
+}
+
+
+/*======================================================================
+	Function:		buildLut2
+	Input:			none
+	Output:			none
+	Description:	Fill the table of lifeStepLut2. It runs before main(),
+					so the table is complete before any tool starts the
+					threads which call the kernel (lifecheck -x).
+======================================================================*/
+static void __attribute__((constructor)) buildLut2(void)
+{
+	uint16_t idx, l, c, r;
+
+	for (idx = 0; idx < (1 << 12); idx++) {
+		l = idx & 15;
+		c = (idx >> 4) & 15;
+		r = (idx >> 8) & 15;
+		lut2[idx] = LIFE_LUT_BIT((l & 7) | (c & 7) << 3 | (r & 7) << 6)
+			| LIFE_LUT_BIT((l >> 1) | (c >> 1) << 3 | (r >> 1) << 6) << 1;
+	}
+}
+
+
+/*======================================================================
+	Function:		lifeStepLut2
+	Input:			see lifeStepLut
+	Output:			none
+	Description:	Table driven kernel with a 3x4 window which yields two
+					cells per lookup. The table has 4096 entries (1 KB with
+					2 bits per entry), too much for the flash of the
+					ATtiny4313, so this kernel exists on the host only.
+======================================================================*/
+void lifeStepLut2(uint8_t* dst, const uint8_t* src, uint8_t cols)
+{
+	uint16_t l, c, r;
+	uint8_t x, y, next;
+
+	for (x = 0; x < cols; x++) {
+		l = LIFE_WRAP_COLUMN(src[(x == 0) ? (cols - 1) : (x - 1)]);
+		c = LIFE_WRAP_COLUMN(src[x]);
+		r = LIFE_WRAP_COLUMN(src[(x == (cols - 1)) ? 0 : (x + 1)]);
+		next = 0;
+
+		for (y = 0; y < DISP_ROWS; y += 2) {
+			next |= lut2[(l & 15) | (c & 15) << 4 | (r & 15) << 8] << y;
+			l >>= 2;
+			c >>= 2;
+			r >>= 2;
+		}
+		dst[x] = next & ((1 << DISP_ROWS) - 1);
+	}
+}
+
+
+void lifeStepBlocked1(uint8_t* dst, const uint8_t* src, uint8_t cols)
+{
+	lifeStepBlocked(dst, src, cols, 1);
+}
+
+
+void lifeStepBlocked4(uint8_t* dst, const uint8_t* src, uint8_t cols)
+{
+	lifeStepBlocked(dst, src, cols, 4);
+}
+
+
+const kernel_t* findKernel(const char* name)
+{
+	const kernel_t* k;
+
+	for (k = kernels; k->name; k++) {
+		if (strcmp(k->name, name) == 0) {
+			return k;
+		}
+	}
+	return NULL;
+}
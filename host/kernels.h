@@ -0,0 +1,60 @@
+/*
+ * kernels.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Generation kernels available to the host side tools
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	const char* name;
+	void (*step)(uint8_t* dst, const uint8_t* src, uint8_t cols);	// see life.h
+	uint8_t gens;						// generations computed per call
+} kernel_t;
+
+
+/********************
+ * global variables *
+ ********************/
+
+extern const kernel_t kernels[];		// terminated by an entry with name = NULL
+
+
+/**************
+ * prototypes *
+ **************/
+void lifeStepAsmModel(uint8_t* dst, const uint8_t* src, uint8_t cols);
+void lifeStepLut2(uint8_t* dst, const uint8_t* src, uint8_t cols);
+void lifeStepBlocked1(uint8_t* dst, const uint8_t* src, uint8_t cols);
+void lifeStepBlocked4(uint8_t* dst, const uint8_t* src, uint8_t cols);
+const kernel_t* findKernel(const char* name);
+
+
+#endif /* KERNELS_H_ */
@@ -0,0 +1,255 @@
+/*
+ * lifebench.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Host benchmark of the generation kernels for several world
+					widths and seed densities. Prints generations per second
+					and nanoseconds per cell as mean, standard deviation and
+					minimum over several repetitions.
+Usage:				lifebench [-k kernel] [-g generations] [-r repetitions]
+					[-w warm-up generations] [-o text|csv|json]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "dot_matrix.h"
+#include "life.h"
+#include "kernels.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define MAX_COLS		240				// DISP_MAX limit
+#define MAX_REPS		1000
+
+static const uint8_t widths[] = {5, 8, 64, 240};
+static const uint8_t densities[] = {50, 25, 10, 3};	// live cells of the initial soup [%], 50 = dmWakeUp()
+
+enum {FORMAT_TEXT, FORMAT_CSV, FORMAT_JSON};
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	double mean;						// ns per generation
+	double stddev;
+	double min;
+} result_t;
+
+
+/*************
+ * functions *
+ *************/
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/*======================================================================
+	Function:		seedWorld
+	Input:			world, number of columns, density [%]
+	Output:			none
+	Description:	Fill the world with a reproducible soup. 50 % uses the
+					same distribution as dmWakeUp(), lower densities set
+					every cell individually.
+======================================================================*/
+static void seedWorld(uint8_t* world, uint8_t cols, uint8_t density)
+{
+	uint8_t x, y;
+
+	srand(1);
+	for (x = 0; x < cols; x++) {
+		if (density == 50) {
+			world[x] = rand() % 0x80;
+			continue;
+		}
+		world[x] = 0;
+		for (y = 0; y < DISP_ROWS; y++) {
+			if (rand() % 100 < density) {
+				world[x] |= 1 << y;
+			}
+		}
+	}
+}
+
+
+/*======================================================================
+	Function:		measure
+	Input:			kernel, number of columns, density [%],
+					generations, repetitions, warm-up generations
+	Output:			statistics of the time per generation [ns]
+	Description:	Every repetition starts from the same soup, runs the
+					warm-up generations untimed and then times the
+					requested number of kernel calls (k->gens generations
+					each).
+======================================================================*/
+static result_t measure(const kernel_t* k, uint8_t cols, uint8_t density, long gens, int reps, long warmup)
+{
+	uint8_t a[MAX_COLS], b[MAX_COLS];
+	double t[MAX_REPS];
+	result_t res = {0, 0, 0};
+	long g;
+	int r;
+
+	for (r = 0; r < reps; r++) {
+		seedWorld(a, cols, density);
+		for (g = 0; g < warmup; g += 2) {
+			k->step(b, a, cols);
+			k->step(a, b, cols);
+		}
+		t[r] = now();
+		for (g = 0; g < gens; g += 2) {
+			k->step(b, a, cols);
+			k->step(a, b, cols);
+		}
+		t[r] = (now() - t[r]) * 1e9 / gens / k->gens;
+		res.mean += t[r];
+		if (r == 0 || t[r] < res.min) {
+			res.min = t[r];
+		}
+	}
+	res.mean /= reps;
+	for (r = 0; r < reps; r++) {
+		res.stddev += (t[r] - res.mean) * (t[r] - res.mean);
+	}
+	res.stddev = (reps > 1) ? sqrt(res.stddev / (reps - 1)) : 0;
+	return res;
+}
+
+
+static void usage(void)
+{
+	const kernel_t* k;
+
+	fprintf(stderr, "usage: lifebench [-k kernel] [-g generations] [-r repetitions] [-w warm-up] [-o text|csv|json]\n");
+	fprintf(stderr, "kernels:");
+	for (k = kernels; k->name; k++) {
+		fprintf(stderr, " %s", k->name);
+	}
+	fprintf(stderr, "\n");
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	const kernel_t* k;
+	const char* only = NULL;
+	long gens = 100000, warmup = 1000;
+	int reps = 5;
+	int format = FORMAT_TEXT;
+	int first = 1;
+	unsigned i, j;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "k:g:r:w:o:")) != -1) {
+		switch (opt) {
+			case 'k': only = optarg; break;
+			case 'g': gens = atol(optarg); break;
+			case 'r': reps = atoi(optarg); break;
+			case 'w': warmup = atol(optarg); break;
+			case 'o':
+				if (!strcmp(optarg, "text")) format = FORMAT_TEXT;
+				else if (!strcmp(optarg, "csv")) format = FORMAT_CSV;
+				else if (!strcmp(optarg, "json")) format = FORMAT_JSON;
+				else usage();
+				break;
+			default: usage();
+		}
+	}
+	if (gens < 2 || reps < 1 || reps > MAX_REPS || warmup < 0) {
+		usage();
+	}
+	if (only && !findKernel(only)) {
+		usage();
+	}
+	gens += gens & 1;					// the kernels run in pairs (a -> b -> a)
+
+	switch (format) {
+		case FORMAT_TEXT:
+			printf("%-10s %6s %8s %12s %10s %8s %10s\n",
+				"kernel", "width", "density", "gens/s", "ns/cell", "stddev%", "min ns/cell");
+			break;
+		case FORMAT_CSV:
+			printf("kernel,width,density,generations,repetitions,ns_per_gen_mean,ns_per_gen_stddev,ns_per_gen_min,gens_per_sec,ns_per_cell\n");
+			break;
+		case FORMAT_JSON:
+			printf("[\n");
+			break;
+	}
+	for (i = 0; i < sizeof(widths); i++) {
+		uint8_t cols = widths[i];
+
+		for (j = 0; j < sizeof(densities); j++) {
+			for (k = kernels; k->name; k++) {
+				uint8_t density = densities[j];
+				unsigned cells = cols * DISP_ROWS;
+				result_t res;
+
+				if (only && strcmp(only, k->name)) {
+					continue;
+				}
+				res = measure(k, cols, density, gens, reps, warmup);
+				switch (format) {
+					case FORMAT_TEXT:
+						printf("%-10s %6u %7u%% %12.0f %10.2f %8.1f %10.2f\n",
+							k->name, cols, density, 1e9 / res.mean, res.mean / cells,
+							100 * res.stddev / res.mean, res.min / cells);
+						break;
+					case FORMAT_CSV:
+						printf("%s,%u,%u,%ld,%d,%.2f,%.2f,%.2f,%.0f,%.4f\n",
+							k->name, cols, density, gens * k->gens, reps, res.mean, res.stddev, res.min,
+							1e9 / res.mean, res.mean / cells);
+						break;
+					case FORMAT_JSON:
+						printf("%s  {\"kernel\": \"%s\", \"width\": %u, \"density\": %u, "
+							"\"generations\": %ld, \"repetitions\": %d, "
+							"\"ns_per_gen\": {\"mean\": %.2f, \"stddev\": %.2f, \"min\": %.2f}, "
+							"\"gens_per_sec\": %.0f, \"ns_per_cell\": %.4f}",
+							first ? "" : ",\n", k->name, cols, density, gens * k->gens, reps,
+							res.mean, res.stddev, res.min, 1e9 / res.mean, res.mean / cells);
+						break;
+				}
+				first = 0;
+				fflush(stdout);
+			}
+		}
+	}
+	if (format == FORMAT_JSON) {
+		printf("\n]\n");
+	}
+	return 0;
+}
@@ -0,0 +1,396 @@
+/*
+ * lifecheck.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Differential check of the generation kernels (life.c).
+					Every kernel is compared against an independent oracle which is
+					tabulated for all 2^21 combinations of three adjacent columns.
+
+					lifecheck [-k kernel] [-j threads] -x [-r first:last]
+						exhaustive check of all 2^35 5x7 worlds, split into 2^14
+						chunks of 2^21 worlds (-r restricts the chunk range)
+					lifecheck [-k kernel] -n count [-s seed]
+						random worlds of random width (1..240 columns)
+					lifecheck [-k kernel] -d generations [-s seed]
+						run the firmware loop (kernel plus reseeding) with every
+						kernel and compare frames and reseed events
+
+					The first mismatching world is reported and the exit status is 1.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "dot_matrix.h"
+#include "life.h"
+#include "kernels.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define COLS_5x7		5
+#define MAX_COLS		240				// DISP_MAX limit
+#define ROW_MASK		((1 << DISP_ROWS) - 1)
+#define CHUNK_BITS		21				// worlds per chunk = 3 columns
+#define CHUNKS			(1L << (7 * COLS_5x7 - CHUNK_BITS))
+
+
+/********************
+ * global variables *
+ ********************/
+
+static uint8_t oracle[1L << 21];		// next state of column c, index = l << 14 | c << 7 | r
+
+static const kernel_t* check_kernel;	// kernel under test in the exhaustive check
+static atomic_long next_chunk;
+static long last_chunk;
+static atomic_llong first_mismatch;		// smallest mismatching world (-1 = none)
+
+
+/*************
+ * functions *
+ *************/
+
+/*======================================================================
+	Function:		buildOracle
+	Description:	Tabulate the next state of a column for all possible
+					neighbour columns. Deliberately written differently from
+					every kernel: cells are addressed with modular arithmetic.
+======================================================================*/
+static void buildOracle(void)
+{
+	long idx;
+	int y, dx, dy;
+
+	for (idx = 0; idx < (1L << 21); idx++) {
+		uint8_t col[3] = {(idx >> 14) & 0x7F, (idx >> 7) & 0x7F, idx & 0x7F};
+		uint8_t next = 0;
+
+		for (y = 0; y < DISP_ROWS; y++) {
+			int n = 0;
+			for (dx = 0; dx < 3; dx++) {
+				for (dy = -1; dy <= 1; dy++) {
+					if (dx == 1 && dy == 0) {
+						continue;
+					}
+					n += (col[dx] >> ((y + dy + DISP_ROWS) % DISP_ROWS)) & 1;
+				}
+			}
+			if ((((col[1] >> y) & 1) ? LIFE_SURVIVE : LIFE_BIRTH) & (1 << n)) {
+				next |= 1 << y;
+			}
+		}
+		oracle[idx] = next;
+	}
+}
+
+
+static void stepOracle(uint8_t* dst, const uint8_t* src, uint8_t cols)
+{
+	uint8_t x;
+
+	for (x = 0; x < cols; x++) {
+		uint8_t l = src[(x + cols - 1) % cols];
+		uint8_t r = src[(x + 1) % cols];
+		dst[x] = oracle[(long)l << 14 | (long)src[x] << 7 | r];
+	}
+}
+
+
+// oracle applied several times (reference for kernels with gens > 1)
+static void stepOracleGens(uint8_t* dst, const uint8_t* src, uint8_t cols, uint8_t gens)
+{
+	uint8_t tmp[MAX_COLS];
+
+	stepOracle(dst, src, cols);
+	while (--gens) {
+		memcpy(tmp, dst, cols);
+		stepOracle(dst, tmp, cols);
+	}
+}
+
+
+static void printWorld(const char* label, const uint8_t* w, uint8_t cols)
+{
+	uint8_t x;
+
+	printf("%-10s", label);
+	for (x = 0; x < cols; x++) {
+		printf(" %02x", w[x]);
+	}
+	printf("\n");
+}
+
+
+static void reportMismatch(const kernel_t* k, const uint8_t* src, uint8_t cols)
+{
+	uint8_t got[MAX_COLS], want[MAX_COLS];
+
+	k->step(got, src, cols);
+	stepOracleGens(want, src, cols, k->gens);
+	printf("kernel %s: mismatch for a world of %u columns\n", k->name, cols);
+	printWorld("world", src, cols);
+	printWorld("expected", want, cols);
+	printWorld("got", got, cols);
+}
+
+
+/*======================================================================
+	Function:		exhaustiveWorker
+	Description:	Check chunks until all are done. Chunks are handed out in
+					ascending order, so chunks beyond a known mismatch are
+					skipped and the smallest mismatch is found.
+======================================================================*/
+static void* exhaustiveWorker(void* arg)
+{
+	uint8_t src[COLS_5x7], dst[COLS_5x7], want[COLS_5x7];
+	long chunk;
+	long low;
+	uint8_t x;
+
+	(void)arg;
+	while ((chunk = atomic_fetch_add(&next_chunk, 1)) <= last_chunk) {
+		long long base = (long long)chunk << CHUNK_BITS;
+
+		if (atomic_load(&first_mismatch) >= 0 && atomic_load(&first_mismatch) < base) {
+			break;
+		}
+		src[3] = (chunk >> 0) & 0x7F;
+		src[4] = (chunk >> 7) & 0x7F;
+		for (low = 0; low < (1L << CHUNK_BITS); low++) {
+			src[0] = low & 0x7F;
+			src[1] = (low >> 7) & 0x7F;
+			src[2] = (low >> 14) & 0x7F;
+			check_kernel->step(dst, src, COLS_5x7);
+			if (check_kernel->gens == 1) {
+				for (x = 0; x < COLS_5x7; x++) {
+					uint8_t l = src[x == 0 ? COLS_5x7 - 1 : x - 1];
+					uint8_t r = src[x == COLS_5x7 - 1 ? 0 : x + 1];
+					if (dst[x] != oracle[(long)l << 14 | (long)src[x] << 7 | r]) {
+						break;
+					}
+				}
+			}
+			else {
+				stepOracleGens(want, src, COLS_5x7, check_kernel->gens);
+				x = memcmp(dst, want, COLS_5x7) ? 0 : COLS_5x7;
+			}
+			if (x < COLS_5x7) {
+				long long world = base | low;
+				long long cur = atomic_load(&first_mismatch);
+				while ((cur < 0 || world < cur)
+						&& !atomic_compare_exchange_weak(&first_mismatch, &cur, world));
+				break;
+			}
+		}
+	}
+	return NULL;
+}
+
+
+static int checkExhaustive(const kernel_t* k, int threads, long first, long last)
+{
+	pthread_t tid[256];
+	int i;
+
+	check_kernel = k;
+	atomic_store(&next_chunk, first);
+	last_chunk = last;
+	atomic_store(&first_mismatch, -1);
+	for (i = 0; i < threads; i++) {
+		pthread_create(&tid[i], NULL, exhaustiveWorker, NULL);
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(tid[i], NULL);
+	}
+
+	if (atomic_load(&first_mismatch) >= 0) {
+		long long world = atomic_load(&first_mismatch);
+		uint8_t src[COLS_5x7];
+		for (i = 0; i < COLS_5x7; i++) {
+			src[i] = (world >> (7 * i)) & 0x7F;
+		}
+		reportMismatch(k, src, COLS_5x7);
+		return 1;
+	}
+	printf("kernel %s: chunks %ld..%ld (%lld worlds) ok\n", k->name, first, last,
+		(long long)(last - first + 1) << CHUNK_BITS);
+	return 0;
+}
+
+
+static int checkRandom(const kernel_t* k, long count, unsigned seed)
+{
+	uint8_t src[MAX_COLS], got[MAX_COLS], want[MAX_COLS];
+	long i;
+	uint8_t x, cols;
+
+	srand(seed);
+	for (i = 0; i < count; i++) {
+		cols = 1 + rand() % MAX_COLS;
+		for (x = 0; x < cols; x++) {
+			src[x] = rand() & ROW_MASK;
+		}
+		k->step(got, src, cols);
+		stepOracleGens(want, src, cols, k->gens);
+		if (memcmp(got, want, cols) != 0) {
+			reportMismatch(k, src, cols);
+			return 1;
+		}
+	}
+	printf("kernel %s: %ld random worlds ok\n", k->name, count);
+	return 0;
+}
+
+
+/*======================================================================
+	Function:		runFirmware
+	Description:	Run the main loop of the firmware (generation, still life
+					detection, reseeding with rand() like dmWakeUp) and
+					summarize the frames and reseed events in a hash.
+======================================================================*/
+static uint64_t runFirmware(void (*step)(uint8_t*, const uint8_t*, uint8_t),
+		long gens, unsigned seed, long* reseeds)
+{
+	uint8_t world[COLS_5x7], next[COLS_5x7];
+	uint64_t hash = 14695981039346656037ULL;
+	long g;
+	uint8_t x;
+
+	srand(seed);
+	lifeResetCounters();
+	for (x = 0; x < COLS_5x7; x++) {
+		world[x] = rand() % 0x80;
+	}
+	*reseeds = 0;
+	for (g = 0; g < gens; g++) {
+		step(next, world, COLS_5x7);
+		if (lifeReseedDue(memcmp(next, world, COLS_5x7) == 0)) {
+			for (x = 0; x < COLS_5x7; x++) {
+				next[x] = rand() % 0x80;
+			}
+			(*reseeds)++;
+			hash = (hash ^ (uint64_t)g) * 1099511628211ULL;
+		}
+		memcpy(world, next, COLS_5x7);
+		for (x = 0; x < COLS_5x7; x++) {
+			hash = (hash ^ world[x]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+
+static int checkFirmware(const kernel_t* k, long gens, unsigned seed)
+{
+	long want_reseeds, got_reseeds;
+	uint64_t want, got;
+
+	if (k->gens != 1) {
+		printf("kernel %s: skipped, the firmware loop needs a single generation per step\n", k->name);
+		return 0;
+	}
+	want = runFirmware(stepOracle, gens, seed, &want_reseeds);
+	got = runFirmware(k->step, gens, seed, &got_reseeds);
+
+	if (got != want) {
+		printf("kernel %s: firmware run differs (%ld reseeds, expected %ld)\n",
+			k->name, got_reseeds, want_reseeds);
+		return 1;
+	}
+	printf("kernel %s: %ld generations with %ld reseeds ok\n", k->name, gens, want_reseeds);
+	return 0;
+}
+
+
+static void usage(void)
+{
+	const kernel_t* k;
+
+	fprintf(stderr, "usage: lifecheck [-k kernel] [-j threads] (-x [-r first:last] | -n count | -d generations) [-s seed]\n");
+	fprintf(stderr, "kernels:");
+	for (k = kernels; k->name; k++) {
+		fprintf(stderr, " %s", k->name);
+	}
+	fprintf(stderr, "\n");
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	const kernel_t* k;
+	const char* only = NULL;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	long first = 0, last = CHUNKS - 1;
+	long count = 0, gens = 0;
+	int exhaustive = 0;
+	unsigned seed = 1;
+	int failed = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "k:j:xr:n:d:s:")) != -1) {
+		switch (opt) {
+			case 'k': only = optarg; break;
+			case 'j': threads = atoi(optarg); break;
+			case 'x': exhaustive = 1; break;
+			case 'r':
+				if (sscanf(optarg, "%ld:%ld", &first, &last) != 2 || first < 0 || last >= CHUNKS) {
+					usage();
+				}
+				break;
+			case 'n': count = atol(optarg); break;
+			case 'd': gens = atol(optarg); break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			default: usage();
+		}
+	}
+	if (!exhaustive && !count && !gens) {
+		usage();
+	}
+	if (threads < 1 || threads > 256) {
+		threads = 1;
+	}
+
+	buildOracle();
+	for (k = kernels; k->name; k++) {
+		if (only && strcmp(only, k->name)) {
+			continue;
+		}
+		if (exhaustive) {
+			failed |= checkExhaustive(k, threads, first, last);
+		}
+		if (count) {
+			failed |= checkRandom(k, count, seed);
+		}
+		if (gens) {
+			failed |= checkFirmware(k, gens, seed);
+		}
+	}
+	return failed;
+}
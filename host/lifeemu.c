@@ -0,0 +1,964 @@
+/*
+ * lifeemu.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Runs the unmodified firmware (Hacklace.c, dot_matrix.c,
+					life.c) on the host in virtual time. Timer 0, timer 1 and
+					the pin change interrupt of the push button are emulated
+					from their registers, and a discrete event scheduler calls
+					the interrupt service routines when their flags are set
+					and interrupts are enabled, including nested interrupts.
+					The duration of the interrupt routines and of a generation
+					is given by a cycle model, so hours of device time run in
+					seconds. A scripted user wakes the device, presses the
+					button long to send it to sleep, wakes it again and
+					gives a short and a double press, all with contact
+					bounce, and finally leaves it alone so that the energy
+					scheduler dozes off (watchdog emulated). Reports lost interrupts, missed deadlines,
+					interrupt latency and duration, the long press latency
+					the button events recognized by the firmware and the mean
+					number of lit LEDs (a measure of the LED current).
+					With -S a file of packets (e.g. from lifestream) is fed
+					into the USART from 3 s on at STREAM_BAUD (firmware built
+					with STREAM = 1, make lifeemu STREAM=1); every frame the
+					firmware shows must be one of the intact packets, in order.
+Usage:				lifeemu [-t seconds] [-p press interval] [-q quiet seconds]
+					[-k kernel cycles] [-d display isr cycles] [-s tick isr cycles]
+					[-S stream file]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "config.h"
+#include "dot_matrix.h"
+#include "stream.h"
+
+// from here on the register names stand for their data space addresses
+#undef _SFR_IO8
+#undef _SFR_IO16
+#define _SFR_IO8(a)		((a) + __SFR_OFFSET)
+#define _SFR_IO16(a)	((a) + __SFR_OFFSET)
+
+
+/*************
+ * constants *
+ *************/
+
+#define IO_SIZE			0x60			// data space addresses of the I/O registers
+#define NEVER			UINT64_MAX
+#define MAIN_CYCLES		20				// main loop around a sleep instruction
+#define EEPROM_CYCLES	(F_CPU / 1000 * 34 / 10)	// 3.4 ms per byte
+#define PRODUCE_CYCLES	40				// dmProduce() with a full ring
+#define SHOW_CYCLES		300				// dmShowFrame()
+#define MAX_PRESSES		16384
+#define BOUNCE			(F_CPU / 1000 * 8 / 10)	// contact bounce: 0.8 ms between the edges
+#define STREAM_START	(3 * (uint64_t)F_CPU)	// first byte of the stream file (after the wake-up)
+#define BYTE_TIME(i)	(STREAM_START + (uint64_t)(i) * 10 * F_CPU / STREAM_BAUD)	// 8N1: 10 bits per byte
+
+#define REG16(addr)		(io[addr] | io[(addr) + 1] << 8)
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	const char* name;
+	void (*isr)(void);
+	uint8_t flag_reg, flag_bit;			// data space address / bit of the interrupt flag
+	uint8_t enable_reg, enable_bit;
+	uint32_t cycles;					// duration of the routine (without nested interrupts)
+	uint64_t period;					// deadline after the flag is set [F_CPU cycles], 0 = none
+	uint64_t set_time;					// time the pending flag has been set
+	uint64_t count, lost, missed;
+	uint64_t latency_sum, latency_max, duration_max;
+} vector_t;
+
+typedef struct {
+	uint64_t time;
+	uint8_t pressed;
+	uint8_t bounce;						// edge of the contact bounce (not a new press)
+	uint8_t event;						// expected event unless the press wakes the device up (0 = counted by script())
+} press_t;
+
+
+/********************
+ * global variables *
+ ********************/
+
+// interrupt service routines of the firmware (weak: routines it does not define stay NULL)
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void TIMER1_COMPB_vect(void) __attribute__((weak));
+void TIMER0_COMPB_vect(void) __attribute__((weak));
+void PCINT_D_vect(void) __attribute__((weak));
+void WDT_OVERFLOW_vect(void) __attribute__((weak));
+void USART0_RX_vect(void) __attribute__((weak));
+
+extern volatile uint8_t scroll_enabled;
+extern uint32_t time_active, time_asleep;
+extern volatile uint8_t pb_queue[PB_QUEUE_SIZE], pb_head;
+extern const uint8_t col_port[], col_bit[], row_port[], row_bit[];	// connection map of dot_matrix.c
+extern uint8_t frames_late __attribute__((weak));	// only with LOOKAHEAD_FRAMES
+uint8_t dmProduce(void) __attribute__((weak));
+extern stream_t stream __attribute__((weak));	// only with STREAM
+int firmwareMain(void);					// main() of Hacklace.c, renamed by the Makefile
+
+static uint8_t io[IO_SIZE];				// I/O registers (interrupt flags are kept in flags[])
+static uint8_t flags[IO_SIZE];			// pending interrupt flags per flag register
+
+static uint64_t now;					// virtual time [F_CPU cycles]
+static uint64_t last_sync;
+static uint64_t end_time;
+static uint64_t t0_phase, t1_phase;		// F_CPU cycles since the last timer clock
+static uint64_t wdt_start;				// start of the current watchdog period
+static uint8_t wdt_on;
+static uint8_t sleep_mode_sel, powered_down;
+static jmp_buf finished;
+
+static vector_t vectors[] = {			// in order of priority
+	{"TIMER1_COMPA", NULL, TIFR, OCF1A, TIMSK, OCIE1A, 65},	// naked routine of dot_matrix.c
+	{"USART0_RX",    NULL, UCSRA, RXC,  UCSRB, RXCIE,  50},	// stream.c
+	{"TIMER1_COMPB", NULL, TIFR, OCF1B, TIMSK, OCIE1B, 42},	// blanking of dot_matrix.c
+	{"TIMER0_COMPB", NULL, TIFR, OCF0B, TIMSK, OCIE0B, 100},
+	{"PCINT_D",      NULL, GIFR, PCIF2, GIMSK, PCIE2,  30},
+	{"WDT",          NULL, WDTCR, WDIF, WDTCR, WDIE,   30},
+};
+#define VECTORS		(sizeof(vectors) / sizeof(vectors[0]))
+
+static uint32_t kernel_cycles = 12000;	// one generation (see make report)
+static uint64_t generations;
+static uint64_t sleep_time[2];			// idle / power down [F_CPU cycles]
+static uint64_t div_time[16];			// time per system clock divider (CLKPR)
+
+static press_t presses[MAX_PRESSES];	// scripted button, sorted by time
+static int press_count, press_next;
+static uint64_t press_start;			// time of the current press
+static uint64_t longpress_sum, longpress_min = NEVER, longpress_max, longpress_count;
+static uint64_t wake_sum, wake_max, wake_count;
+static uint8_t longpress_seen, wake_seen;
+static uint8_t pb_seen;					// pb_head at the last observation
+static uint64_t events[8];				// button events by type (PB_SHORT ...)
+static uint64_t events_expected[8];
+static uint8_t leds_lit;				// LEDs lit by the current port state
+static uint64_t leds_since, leds_sum;	// time of the last change, integral of leds_lit [LEDs * cycles]
+static uint64_t lit_sum;				// time with any LED lit
+static uint64_t doze_wakes;				// presses which found the device powered down
+static uint8_t* stream_data;			// stream file fed into the USART
+static size_t stream_size, stream_next;
+static size_t stream_packet;			// start of the packet being fed
+static uint8_t stream_intact;			// all bytes of the packet have been received so far
+static uint64_t stream_lost;			// bytes sent while the receiver was off (power down)
+static uint64_t stream_valid;			// intact packets with a correct checksum
+static size_t* valid_start;				// their offsets in the stream file
+static uint64_t shown, shown_next, mismatched;	// frames passed to dmShowFrame()
+
+
+/*************
+ * functions *
+ *************/
+
+static uint8_t clockDiv(void)
+{
+	return io[CLKPR] & 0x0F;
+}
+
+
+// watchdog period [F_CPU cycles] (128 kHz oscillator, 2K .. 1024K cycles)
+static uint64_t wdtPeriod(void)
+{
+	uint8_t wdp = (io[WDTCR] & 7) | ((io[WDTCR] >> WDP3) & 1) << 3;
+
+	return ((uint64_t)2048 << wdp) * F_CPU / 128000;
+}
+
+
+static uint32_t prescaler(uint8_t cs)
+{
+	static const uint16_t ps[8] = {0, 1, 8, 64, 256, 1024, 0, 0};	// 6, 7 = external clock
+
+	return ps[cs & 7];
+}
+
+
+// timer ticks from cnt until the counter equals target (counting 0 .. top, above top up to 0xFFFF)
+static uint64_t ticksTo(uint16_t cnt, uint16_t target, uint16_t top, uint16_t max)
+{
+	if (cnt <= top) {
+		if (target > top) {
+			return NEVER;
+		}
+		return (target > cnt) ? (uint64_t)(target - cnt) : (uint64_t)(top - cnt) + 1 + target;
+	}
+	return (target > cnt) ? (uint64_t)(target - cnt) : (uint64_t)(max - cnt) + 1 + target;
+}
+
+
+static uint16_t countTicks(uint16_t cnt, uint64_t n, uint16_t top, uint16_t max)
+{
+	uint64_t k;
+
+	if (cnt <= top) {
+		return (cnt + n) % ((uint64_t)top + 1);
+	}
+	k = (uint64_t)max - cnt + 1;		// ticks until the wrap-around
+	return (n < k) ? cnt + n : (n - k) % ((uint64_t)top + 1);
+}
+
+
+static vector_t* findVector(uint8_t reg, uint8_t bit)
+{
+	unsigned i;
+
+	for (i = 0; i < VECTORS; i++) {
+		if (vectors[i].flag_reg == reg && vectors[i].flag_bit == bit) {
+			return &vectors[i];
+		}
+	}
+	return NULL;
+}
+
+
+// set an interrupt flag 'matches' times, the first time at time t
+static void raise(uint8_t reg, uint8_t bit, uint64_t matches, uint64_t t)
+{
+	vector_t* v = findVector(reg, bit);
+
+	if (!matches) {
+		return;
+	}
+	if (!(flags[reg] & _BV(bit))) {
+		flags[reg] |= _BV(bit);
+		if (v) {
+			v->set_time = t;
+		}
+		matches--;
+	}
+	if (v && (io[v->enable_reg] & _BV(v->enable_bit))) {
+		v->lost += matches;				// flag was still set: interrupts lost
+	}
+}
+
+
+// count compare matches of a timer during n ticks
+static void compare(uint16_t cnt, uint64_t n, uint16_t target, uint16_t top, uint16_t max,
+	uint8_t bit, uint64_t start, uint64_t scale)
+{
+	uint64_t d = ticksTo(cnt, target, top, max);
+
+	if (d != NEVER && n >= d) {
+		raise(TIFR, bit, 1 + (n - d) / ((uint64_t)top + 1), start + d * scale);
+	}
+}
+
+
+/*======================================================================
+	Function:		syncTimers
+	Input:			none
+	Output:			none
+	Description:	Bring timer 0 and timer 1 up to the current virtual time
+					and set the compare match flags. Bits written to the flag
+					registers clear the flags (write one to clear).
+======================================================================*/
+static void syncTimers(void)
+{
+	uint64_t dt = now - last_sync;
+	uint64_t start = last_sync;
+
+	flags[TIFR] &= ~io[TIFR];			// write one to clear
+	flags[GIFR] &= ~io[GIFR];
+	io[TIFR] = 0;
+	io[GIFR] = 0;
+	last_sync = now;
+
+	// watchdog in interrupt mode, runs in power down as well
+	if (io[WDTCR] & _BV(WDIE)) {
+		uint64_t period = wdtPeriod();
+
+		if (!wdt_on) {
+			wdt_on = 1;
+			wdt_start = start;				// WDTCR has been written since the last access
+		}
+		if (now - wdt_start >= period) {
+			uint64_t n = (now - wdt_start) / period;
+
+			raise(WDTCR, WDIF, n, wdt_start + period);
+			wdt_start += n * period;
+		}
+	}
+	else {
+		wdt_on = 0;
+	}
+	if (!dt || powered_down) {
+		return;							// the timers stop in power down mode
+	}
+
+	// timer 0: normal mode
+	if (prescaler(io[TCCR0B])) {
+		uint64_t scale = (uint64_t)prescaler(io[TCCR0B]) << clockDiv();
+		uint64_t total = t0_phase + dt, n = total / scale;
+		uint8_t cnt = io[TCNT0];
+
+		compare(cnt, n, io[OCR0B], 0xFF, 0xFF, OCF0B, start - t0_phase, scale);
+		io[TCNT0] = countTicks(cnt, n, 0xFF, 0xFF);
+		t0_phase = total % scale;
+	}
+
+	// timer 1: normal or CTC mode (top = OCR1A)
+	if (prescaler(io[TCCR1B])) {
+		uint64_t scale = (uint64_t)prescaler(io[TCCR1B]) << clockDiv();
+		uint64_t total = t1_phase + dt, n = total / scale;
+		uint16_t cnt = REG16(TCNT1), ocra = REG16(OCR1A), ocrb = REG16(OCR1B);
+		uint16_t top = (io[TCCR1B] & _BV(WGM12)) ? ocra : 0xFFFF;
+
+		compare(cnt, n, ocra, top, 0xFFFF, OCF1A, start - t1_phase, scale);
+		compare(cnt, n, ocrb, top, 0xFFFF, OCF1B, start - t1_phase, scale);
+		cnt = countTicks(cnt, n, top, 0xFFFF);
+		io[TCNT1] = cnt;
+		io[TCNT1 + 1] = cnt >> 8;
+		t1_phase = total % scale;
+	}
+}
+
+
+// earliest time at which an enabled timer interrupt flag is set
+static uint64_t nextTimerEvent(void)
+{
+	uint64_t next = NEVER;
+
+	if (wdt_on && (io[WDTCR] & _BV(WDIE))) {
+		next = wdt_start + wdtPeriod();
+	}
+	if (powered_down) {
+		return next;
+	}
+	if (prescaler(io[TCCR0B]) && (io[TIMSK] & _BV(OCIE0B)) && !(flags[TIFR] & _BV(OCF0B))) {
+		uint64_t scale = (uint64_t)prescaler(io[TCCR0B]) << clockDiv();
+		uint64_t d = ticksTo(io[TCNT0], io[OCR0B], 0xFF, 0xFF);
+
+		next = now + d * scale - t0_phase;
+	}
+	if (prescaler(io[TCCR1B])) {
+		uint64_t scale = (uint64_t)prescaler(io[TCCR1B]) << clockDiv();
+		uint16_t cnt = REG16(TCNT1), ocra = REG16(OCR1A), ocrb = REG16(OCR1B);
+		uint16_t top = (io[TCCR1B] & _BV(WGM12)) ? ocra : 0xFFFF;
+		uint64_t d;
+
+		if ((io[TIMSK] & _BV(OCIE1A)) && !(flags[TIFR] & _BV(OCF1A))) {
+			d = ticksTo(cnt, ocra, top, 0xFFFF);
+			if (d != NEVER && now + d * scale - t1_phase < next) {
+				next = now + d * scale - t1_phase;
+			}
+		}
+		if ((io[TIMSK] & _BV(OCIE1B)) && !(flags[TIFR] & _BV(OCF1B))) {
+			d = ticksTo(cnt, ocrb, top, 0xFFFF);
+			if (d != NEVER && now + d * scale - t1_phase < next) {
+				next = now + d * scale - t1_phase;
+			}
+		}
+	}
+	return next;
+}
+
+
+static uint64_t nextEvent(void)
+{
+	uint64_t next = nextTimerEvent();
+
+	if (press_next < press_count && presses[press_next].time < next) {
+		next = presses[press_next].time;
+	}
+	if (stream_next < stream_size && BYTE_TIME(stream_next) < next) {
+		next = BYTE_TIME(stream_next);
+	}
+	return (end_time < next) ? end_time : next;
+}
+
+
+// button of the scripted user (PD6 = PCINT17, low = pressed)
+static void pressButton(uint8_t pressed, uint8_t bounce, uint8_t event)
+{
+	uint8_t pin = pressed ? (io[PIND] & ~_BV(PB_BIT)) : (io[PIND] | _BV(PB_BIT));
+
+	if (pin != io[PIND] && (io[PCMSK2] & _BV(PCINT17))) {
+		raise(GIFR, PCIF2, 1, now);
+	}
+	io[PIND] = pin;
+	if (pressed && !bounce && event) {
+		if (powered_down) {
+			doze_wakes++;
+		}
+		else {
+			events_expected[event]++;
+		}
+	}
+	if (pressed && !bounce) {
+		press_start = now;
+		longpress_seen = 0;
+		wake_seen = scroll_enabled;
+	}
+}
+
+
+/*======================================================================
+	Function:		feedStream
+	Input:			none
+	Output:			none
+	Description:	Deliver the bytes of the stream file which are due to
+					the USART. In power down the receiver has no clock and
+					the bytes are lost. The packets that arrive complete and
+					with a correct checksum are noted for emuShowFrame().
+======================================================================*/
+static void feedStream(void)
+{
+	while (stream_next < stream_size && BYTE_TIME(stream_next) <= now) {
+		uint8_t byte = stream_data[stream_next];
+
+		if (byte & 0x80) {
+			stream_packet = stream_next;
+			stream_intact = 1;
+		}
+		if (!powered_down && (io[UCSRB] & _BV(RXEN))) {
+			io[UDR] = byte;
+			raise(UCSRA, RXC, 1, BYTE_TIME(stream_next));
+		}
+		else {
+			stream_lost++;
+			stream_intact = 0;
+		}
+		if (stream_intact && stream_next == stream_packet + STREAM_PACKET - 1) {
+			uint8_t sum = 0, x;
+
+			for (x = 0; x < DISP_MAX; x++) {
+				sum = STREAM_SUM(sum, stream_data[stream_packet + 1 + x]);
+			}
+			if (sum == byte) {
+				valid_start[stream_valid++] = stream_packet;
+			}
+		}
+		stream_next++;
+	}
+}
+
+
+static void advanceTo(uint64_t t)
+{
+	if (t > now) {
+		if (sleep_mode_sel != 0xFF) {
+			sleep_time[powered_down] += t - now;
+		}
+		div_time[clockDiv()] += t - now;
+		now = t;
+	}
+	syncTimers();
+	while (press_next < press_count && presses[press_next].time <= now) {
+		pressButton(presses[press_next].pressed, presses[press_next].bounce, presses[press_next].event);
+		press_next++;
+	}
+	feedStream();
+	if (now >= end_time) {
+		longjmp(finished, 1);
+	}
+}
+
+
+// number of LEDs the ports light (selected columns x active rows)
+static uint8_t ledsLit(void)
+{
+	const uint8_t port[3] = {io[PORTA], io[PORTB], io[PORTD]};
+	uint8_t cols = 0, rows = 0, i;
+
+	for (i = 0; i < DISP_COLUMNS; i++) {
+		if (((port[col_port[i]] & col_bit[i]) != 0) == DISP_TYPE) {
+			cols++;
+		}
+	}
+	for (i = 0; i < DISP_ROWS; i++) {
+		if (((port[row_port[i]] & row_bit[i]) != 0) != DISP_TYPE) {
+			rows++;
+		}
+	}
+	return cols * rows;
+}
+
+
+// the scripted user watches the firmware after every interrupt
+static void observe(void)
+{
+	uint8_t lit = ledsLit();
+
+	if (lit != leds_lit) {
+		leds_sum += (uint64_t)leds_lit * (now - leds_since);
+		if (leds_lit) {
+			lit_sum += now - leds_since;
+		}
+		leds_lit = lit;
+		leds_since = now;
+	}
+
+	while (pb_seen != pb_head) {
+		uint8_t event = pb_queue[pb_seen];
+
+		pb_seen = (pb_seen + 1) & (PB_QUEUE_SIZE - 1);
+		events[event & 7]++;
+		if (event == PB_LONG && !longpress_seen) {
+			uint64_t l = now - press_start;
+
+			longpress_seen = 1;
+			longpress_sum += l;
+			longpress_count++;
+			if (l < longpress_min) longpress_min = l;
+			if (l > longpress_max) longpress_max = l;
+		}
+	}
+	if (!wake_seen && scroll_enabled) {
+		uint64_t l = now - press_start;
+
+		wake_seen = 1;
+		wake_sum += l;
+		wake_count++;
+		if (l > wake_max) wake_max = l;
+	}
+}
+
+
+static void consume(uint32_t cycles);
+
+
+/*======================================================================
+	Function:		dispatch
+	Input:			none
+	Output:			number of interrupt routines executed
+	Description:	Execute pending interrupts in the order of the vector
+					table while the I bit is set, like the interrupt logic
+					of the AVR: the flag is cleared, the I bit is cleared
+					until the routine returns, and a routine that enables
+					interrupts (sei) can be interrupted itself.
+======================================================================*/
+static int dispatch(void)
+{
+	int executed = 0;
+	unsigned i;
+
+	while (io[SREG] & 0x80) {
+		vector_t* v = NULL;
+		uint64_t start, latency;
+
+		for (i = 0; i < VECTORS && !v; i++) {
+			if ((flags[vectors[i].flag_reg] & _BV(vectors[i].flag_bit))
+					&& (io[vectors[i].enable_reg] & _BV(vectors[i].enable_bit)) && vectors[i].isr) {
+				v = &vectors[i];
+			}
+		}
+		if (!v) {
+			break;
+		}
+		flags[v->flag_reg] &= ~_BV(v->flag_bit);
+		latency = now - v->set_time;
+		v->count++;
+		v->latency_sum += latency;
+		if (latency > v->latency_max) {
+			v->latency_max = latency;
+		}
+		if (v->period && latency >= v->period) {
+			v->missed++;
+		}
+		io[SREG] &= ~0x80;
+		start = now;
+		consume(v->cycles);
+		v->isr();
+		io[SREG] |= 0x80;			// reti
+		if (now - start > v->duration_max) {
+			v->duration_max = now - start;
+		}
+		observe();
+		executed++;
+	}
+	return executed;
+}
+
+
+/*======================================================================
+	Function:		consume
+	Input:			number of CPU cycles
+	Output:			none
+	Description:	Let the running code take some time. Interrupts that
+					become due in the meantime are executed if the I bit
+					is set, and the interrupted code continues afterwards.
+======================================================================*/
+static void consume(uint32_t cycles)
+{
+	uint64_t left = (uint64_t)cycles << clockDiv();
+
+	while (left) {
+		uint64_t next = nextEvent();
+		uint64_t step = (next - now < left) ? next - now : left;
+
+		advanceTo(now + step);
+		left -= step;
+		dispatch();
+	}
+}
+
+
+/*======================================================================
+	Function:		emuSfr
+	Input:			data space address of an I/O register
+	Output:			pointer to the register
+	Description:	Called by the register macros of avr/io.h. Interrupts
+					that are pending when the I bit is set (e. g. after sei)
+					are executed before the access.
+======================================================================*/
+volatile uint8_t* emuSfr(uint16_t addr)
+{
+	if (addr >= IO_SIZE) {
+		fprintf(stderr, "access to unknown register 0x%02x\n", addr);
+		exit(2);
+	}
+	if (addr) {
+		syncTimers();
+		dispatch();
+	}
+	return &io[addr];
+}
+
+
+void emuSetSleepMode(uint8_t mode)
+{
+	sleep_mode_sel = mode;
+}
+
+
+/*======================================================================
+	Function:		emuSleep
+	Input:			none
+	Output:			none
+	Description:	sleep_mode() / sleep_cpu() of the firmware: advance the
+					virtual time until an interrupt has been executed. An
+					interrupt that is already pending (e.g. raised between
+					cli() and sei() sleep_cpu()) wakes up at once. In power
+					down mode the timers stop and only the push button wakes
+					up.
+======================================================================*/
+void emuSleep(void)
+{
+	uint8_t mode = sleep_mode_sel;
+
+	consume(MAIN_CYCLES);
+	if (!(io[SREG] & 0x80)) {
+		fprintf(stderr, "sleep with interrupts disabled at %.3f s\n", (double)now / F_CPU);
+		exit(1);
+	}
+	powered_down = (mode == SLEEP_MODE_PWR_DOWN);
+	while (!dispatch()) {
+		advanceTo(nextEvent());
+	}
+	powered_down = 0;
+	sleep_mode_sel = mode;
+}
+
+
+// wdt_reset() of the firmware
+void emuWdtReset(void)
+{
+	syncTimers();
+	if (wdt_on) {
+		wdt_start = now;
+	}
+}
+
+
+void emuEepromWrite(uint8_t bytes)
+{
+	consume(bytes * EEPROM_CYCLES);
+}
+
+
+// dmScroll() / dmProduce() of the firmware with the duration of a generation
+uint8_t emuScroll(void)
+{
+	consume(kernel_cycles);
+	generations++;
+	return dmScroll();
+}
+
+
+// dmShowFrame() of the firmware: the frame must be an intact packet after the one shown last
+void emuShowFrame(const uint8_t* frame)
+{
+	uint64_t k;
+
+	for (k = shown_next; k < stream_valid; k++) {
+		if (!memcmp(frame, stream_data + valid_start[k] + 1, DISP_MAX)) {
+			break;
+		}
+	}
+	if (k < stream_valid) {
+		shown_next = k + 1;
+	}
+	else {
+		mismatched++;
+	}
+	shown++;
+	consume(SHOW_CYCLES);
+	dmShowFrame(frame);
+}
+
+
+uint8_t emuProduce(void)
+{
+	if (dmProduce()) {
+		consume(kernel_cycles);
+		generations++;
+		return 1;
+	}
+	consume(PRODUCE_CYCLES);
+	return 0;
+}
+
+
+/*======================================================================
+	Function:		script
+	Input:			duration, interval between long presses [s]
+	Output:			none
+	Description:	The user wakes the device after it has gone to sleep at
+					power-on, and in every interval holds the button for
+					1.5 s (sleep), wakes the device 3 s later again, gives a
+					short press (new world), a double press (scrolling
+					speed) and a short press followed by a long one
+					(brightness). Every edge bounces three times. In the
+					last 'quiet' seconds the button is left alone but for
+					a short press 2 minutes before the end, which either
+					wakes the dozing device or starts a new world.
+======================================================================*/
+static void script(double seconds, double interval, double quiet)
+{
+	double t;
+
+	#define EDGE(at, down, b, e)											\
+		if (press_count < MAX_PRESSES) {									\
+			presses[press_count].time = (uint64_t)((at) * F_CPU) + (b) * BOUNCE;	\
+			presses[press_count].pressed = (down);							\
+			presses[press_count].event = (e);								\
+			presses[press_count++].bounce = (b);							\
+		}
+	#define PRESS_EVENT(at, down, e)										\
+		EDGE(at, down, 0, e) EDGE(at, !(down), 1, 0) EDGE(at, down, 2, 0)
+	#define PRESS(at, down)		PRESS_EVENT(at, down, 0)
+
+	PRESS(1.5, 1);						// wake up (ignored until released)
+	PRESS(1.7, 0);
+	for (t = 1.5 + interval; t + 12 < seconds - quiet; t += interval) {
+		PRESS(t, 1);					// long press
+		PRESS(t + 1.5, 0);
+		PRESS(t + 4.5, 1);				// wake up
+		PRESS(t + 4.7, 0);
+		PRESS(t + 6.0, 1);				// short press
+		PRESS(t + 6.15, 0);
+		PRESS(t + 8.0, 1);				// double press
+		PRESS(t + 8.1, 0);
+		PRESS(t + 8.25, 1);
+		PRESS(t + 8.35, 0);
+		PRESS(t + 10.0, 1);				// brightness
+		PRESS(t + 10.1, 0);
+		PRESS(t + 10.25, 1);
+		PRESS(t + 11.75, 0);
+		events_expected[PB_LONG]++;
+		events_expected[PB_SHORT]++;
+		events_expected[PB_DOUBLE]++;
+		events_expected[PB_DOUBLE_LONG]++;
+	}
+	if (quiet > 120) {
+		PRESS_EVENT(seconds - 120, 1, PB_SHORT);
+		PRESS(seconds - 120 + 0.15, 0);
+	}
+	#undef PRESS
+	#undef PRESS_EVENT
+	#undef EDGE
+}
+
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: lifeemu [-t seconds] [-p press interval] [-q quiet seconds] [-k kernel cycles] [-d display isr cycles] [-s tick isr cycles]\n");
+	fprintf(stderr, "               [-S stream file]\n");
+	exit(2);
+}
+
+
+static double us(uint64_t cycles)
+{
+	return cycles * 1e6 / F_CPU;
+}
+
+
+int main(int argc, char** argv)
+{
+	double seconds = 3600, interval = 60, quiet = 1200;
+	const char* stream_file = NULL;
+	int failed = 0;
+	struct timespec t0, t1;
+	unsigned i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:p:q:k:d:s:S:")) != -1) {
+		switch (opt) {
+			case 't': seconds = atof(optarg); break;
+			case 'p': interval = atof(optarg); break;
+			case 'q': quiet = atof(optarg); break;
+			case 'k': kernel_cycles = strtoul(optarg, NULL, 0); break;
+			case 'd': vectors[0].cycles = strtoul(optarg, NULL, 0); break;
+			case 's': vectors[3].cycles = strtoul(optarg, NULL, 0); break;
+			case 'S': stream_file = optarg; break;
+			default: usage();
+		}
+	}
+	if (seconds <= 0 || interval < 10 || quiet < 0) {
+		usage();
+	}
+	end_time = (uint64_t)(seconds * F_CPU);
+	if (stream_file) {
+		FILE* f = fopen(stream_file, "rb");
+
+		if (!&stream) {
+			fprintf(stderr, "lifeemu: the firmware has been built without STREAM (make lifeemu STREAM=1)\n");
+			exit(2);
+		}
+		if (!f || fseek(f, 0, SEEK_END) || (long)(stream_size = ftell(f)) < 0) {
+			perror(stream_file);
+			exit(2);
+		}
+		rewind(f);
+		stream_data = malloc(stream_size + 1);
+		valid_start = malloc((stream_size / STREAM_PACKET + 1) * sizeof(*valid_start));
+		if (!stream_data || !valid_start || fread(stream_data, 1, stream_size, f) != stream_size) {
+			perror(stream_file);
+			exit(2);
+		}
+		fclose(f);
+		while (stream_size && BYTE_TIME(stream_size) >= end_time) {
+			stream_size--;			// only bytes the firmware can read before the end are sent
+		}
+	}
+	vectors[0].isr = TIMER1_COMPA_vect;
+	vectors[1].isr = USART0_RX_vect;
+	vectors[2].isr = TIMER1_COMPB_vect;
+	vectors[3].isr = TIMER0_COMPB_vect;
+	vectors[4].isr = PCINT_D_vect;
+	vectors[5].isr = WDT_OVERFLOW_vect;
+	vectors[0].period = F_CPU / COLUMN_FREQ;
+	vectors[1].period = 10 * F_CPU / STREAM_BAUD;	// the next byte overwrites UDR
+	vectors[2].period = F_CPU / COLUMN_FREQ;
+	vectors[3].period = F_CPU / SYS_TIMER_FREQ;
+	io[PIND] = 0xFF;				// button released (pull-up)
+	sleep_mode_sel = 0xFF;				// not sleeping
+	script(seconds, interval, quiet);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (!setjmp(finished)) {
+		firmwareMain();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	printf("%.0f s of device time in %.2f s\n", (double)now / F_CPU,
+		t1.tv_sec - t0.tv_sec + (t1.tv_nsec - t0.tv_nsec) * 1e-9);
+	printf("%-14s %10s %8s %8s %14s %14s %14s\n", "interrupt", "count", "lost", "missed",
+		"latency [us]", "max latency", "max duration");
+	for (i = 0; i < VECTORS; i++) {
+		vector_t* v = &vectors[i];
+
+		if (!v->isr) {
+			continue;
+		}
+		printf("%-14s %10" PRIu64 " %8" PRIu64 " %8" PRIu64 " %14.1f %14.1f %14.1f\n", v->name,
+			v->count, v->lost, v->missed, v->count ? us(v->latency_sum / v->count) : 0,
+			us(v->latency_max), us(v->duration_max));
+		if (v->period && (v->lost || v->missed)) {
+			failed = 1;
+		}
+		if (v->period && v->duration_max > v->period) {
+			failed = 1;
+			printf("  %s overruns its period of %.0f us\n", v->name, us(v->period));
+		}
+	}
+	printf("generations: %" PRIu64 " (%.1f per second awake)\n", generations,
+		generations / ((now - sleep_time[1]) / (double)F_CPU));
+	printf("asleep: %.1f %% idle, %.1f %% power down\n",
+		100.0 * sleep_time[0] / now, 100.0 * sleep_time[1] / now);
+	if (div_time[0] != now) {
+		printf("system clock:");
+		for (i = 0; i < 16; i++) {
+			if (div_time[i]) {
+				printf(" %.1f %% at %lu kHz", 100.0 * div_time[i] / now, (unsigned long)(F_CPU >> i) / 1000);
+			}
+		}
+		printf("\n");
+	}
+	if (longpress_count) {
+		printf("long press latency: %.1f / %.1f / %.1f ms (min / mean / max, %" PRIu64 " presses)\n",
+			us(longpress_min) / 1000, us(longpress_sum / longpress_count) / 1000,
+			us(longpress_max) / 1000, longpress_count);
+	}
+	if (wake_count) {
+		printf("wake-up latency: %.1f / %.1f ms (mean / max)\n",
+			us(wake_sum / wake_count) / 1000, us(wake_max) / 1000);
+	}
+	printf("button events: %" PRIu64 " short, %" PRIu64 " long, %" PRIu64 " double, %" PRIu64
+		" short + long (expected %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 ")\n",
+		events[PB_SHORT], events[PB_LONG], events[PB_DOUBLE], events[PB_DOUBLE_LONG],
+		events_expected[PB_SHORT], events_expected[PB_LONG], events_expected[PB_DOUBLE],
+		events_expected[PB_DOUBLE_LONG]);
+	for (i = 1; i < 8; i++) {
+		if (events[i] != events_expected[i]) {
+			failed = 1;
+		}
+	}
+	leds_sum += (uint64_t)leds_lit * (now - leds_since);
+	if (leds_lit) {
+		lit_sum += now - leds_since;
+	}
+	printf("LEDs: %.2f lit on average while awake, a column is lit %.1f %% of the time\n",
+		(double)leds_sum / (now - sleep_time[1]), 100.0 * lit_sum / (now - sleep_time[1]));
+	printf("firmware time counters: %lu s awake, %lu s asleep (emulated: %.0f s awake, %.0f s power down), %"
+		PRIu64 " presses woke the dozing device\n", (unsigned long)time_active, (unsigned long)time_asleep,
+		(double)(now - sleep_time[1]) / F_CPU, (double)sleep_time[1] / F_CPU, doze_wakes);
+	if (&frames_late) {
+		printf("frames late: %u\n", frames_late);
+	}
+	if (stream_file) {
+		printf("stream: %" PRIu64 " intact packets of %zu bytes (%" PRIu64 " bytes lost in power down), firmware: %u frames, "
+			"%u dropped, %u errors, %" PRIu64 " shown (%" PRIu64 " not sent or out of order)\n", stream_valid, stream_size,
+			stream_lost, stream.frames, stream.dropped, stream.errors, shown, mismatched);
+		if ((stream.dropped != 0xFF && (uint16_t)(stream.frames + stream.dropped) != (uint16_t)stream_valid)
+				|| (uint16_t)(shown + stream.ready) != stream.frames || mismatched) {
+			failed = 1;				// (the counters of the firmware wrap around / saturate)
+		}
+	}
+	return failed;
+}
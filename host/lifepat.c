@@ -0,0 +1,296 @@
+/*
+ * lifepat.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Converts Life patterns between the RLE, plaintext and
+					macrocell formats with the pattern I/O of patio.c and
+					measures its speed. With -b and a file the file is parsed
+					repeatedly from memory and the parse throughput is printed
+					in GB/s; with -b alone a random torus is exported in every
+					format, loaded again and compared against the original.
+Usage:				lifepat [-W width] [-H height] [-f rle|cells|mc] [-o output] input
+					lifepat -b [-W width] [-H height] [-d density] [input]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "torus.h"
+#include "patio.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define MIN_TIME		1.0				// minimum duration of a measurement [s]
+
+static const char* const format_names[] = {"rle", "cells", "mc"};
+static const char* const format_exts[] = {".rle", ".cells", ".mc"};
+
+
+/*************
+ * functions *
+ *************/
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static uint32_t roundUp(uint64_t n)
+{
+	n = (n + TORUS_TILE - 1) / TORUS_TILE * TORUS_TILE;
+	return n ? n : TORUS_TILE;
+}
+
+
+static char* readFile(const char* file, size_t* size)
+{
+	FILE* f = fopen(file, "rb");
+	struct stat st;
+	char* data;
+
+	if (!f || fstat(fileno(f), &st)) {
+		perror(file);
+		exit(1);
+	}
+	data = malloc(st.st_size ? st.st_size : 1);
+	if (!data || fread(data, 1, st.st_size, f) != (size_t)st.st_size) {
+		perror(file);
+		exit(1);
+	}
+	fclose(f);
+	*size = st.st_size;
+	return data;
+}
+
+
+/*======================================================================
+	Function:		parseSpeed
+	Input:			file contents, format, world
+	Output:			parse throughput [bytes/s]
+	Description:	Parse the data repeatedly for at least MIN_TIME from
+					memory, so that only the parser is measured.
+======================================================================*/
+static double parseSpeed(const char* data, size_t size, int format, torus_t* t)
+{
+	pat_target_t target = patTargetTorus(t);
+	pat_info_t info;
+	double start = now(), time;
+	long n = 0;
+
+	torusClear(t);						// the cells are or-ed, so the world stays the same
+	do {
+		if (patParse(data, size, format, &target, &info)) {
+			fprintf(stderr, "lifepat: %s\n", patError());
+			exit(1);
+		}
+		n++;
+		time = now() - start;
+	} while (time < MIN_TIME);
+	return (double)size * n / time;
+}
+
+
+static int sameWorld(torus_t* a, torus_t* b)
+{
+	uint32_t tx, ty;
+
+	for (ty = 0; ty < torusHeight(a) / TORUS_TILE; ty++) {
+		for (tx = 0; tx < torusWidth(a) / TORUS_TILE; tx++) {
+			if (memcmp(torusTile(a, tx, ty), torusTile(b, tx, ty), TORUS_TILE * sizeof(uint64_t))) {
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+
+/*======================================================================
+	Function:		roundTrip
+	Input:			width, height, density [%]
+	Output:			0 if every format reproduces the world
+	Description:	Export a random torus in every format, load the files
+					again, compare them against the original and print the
+					file size and the speed of export and import.
+======================================================================*/
+static int roundTrip(uint32_t w, uint32_t h, unsigned density)
+{
+	torus_t* t = torusCreate(w, h, 1);
+	torus_t* u = torusCreate(w, h, 1);
+	pat_target_t src, dst;
+	pat_info_t info;
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	uint32_t x, y;
+	int format, failed = 0;
+
+	if (!t || !u) {
+		fprintf(stderr, "lifepat: width and height must be multiples of %d\n", TORUS_TILE);
+		return 1;
+	}
+	for (x = 0; x < w; x++) {
+		for (y = 0; y < h; y++) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			if (state % 100 < density) {
+				torusSetCell(t, x, y, 1);
+			}
+		}
+	}
+	src = patTargetTorus(t);
+	dst = patTargetTorus(u);
+	printf("%ux%u torus, %" PRIu64 " cells alive\n", w, h, torusPopulation(t));
+	printf("%-6s %12s %10s %12s %12s  %s\n", "format", "bytes", "bits/cell", "export MB/s", "import GB/s", "check");
+	for (format = PAT_RLE; format <= PAT_MACROCELL; format++) {
+		char file[64];
+		size_t size;
+		char* data;
+		double time, speed;
+		int fd, same;
+
+		snprintf(file, sizeof(file), "/tmp/lifepat.XXXXXX%s", format_exts[format]);
+		if ((fd = mkstemps(file, strlen(format_exts[format]))) < 0) {
+			perror(file);
+			return 1;
+		}
+		close(fd);
+		time = now();
+		if (patSave(file, format, &src, NULL)) {
+			fprintf(stderr, "lifepat: %s\n", patError());
+			return 1;
+		}
+		time = now() - time;
+		data = readFile(file, &size);
+		speed = parseSpeed(data, size, format, u);
+		torusClear(u);
+		same = !patParse(data, size, format, &dst, &info) && sameWorld(t, u);
+		printf("%-6s %12zu %10.3f %12.1f %12.3f  %s\n", format_names[format], size,
+			8.0 * size / ((double)w * h), size / time * 1e-6, speed * 1e-9, same ? "ok" : "MISMATCH");
+		failed |= !same;
+		free(data);
+		unlink(file);
+	}
+	torusDestroy(t);
+	torusDestroy(u);
+	return failed;
+}
+
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: lifepat [-W width] [-H height] [-f rle|cells|mc] [-o output] input\n");
+	fprintf(stderr, "       lifepat -b [-W width] [-H height] [-d density] [input]\n");
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	uint32_t w = 0, h = 0;
+	unsigned density = 30;
+	int bench = 0, format = -1;
+	const char* output = NULL;
+	pat_target_t target;
+	pat_info_t info;
+	torus_t* t;
+	double time;
+	int i, opt;
+
+	while ((opt = getopt(argc, argv, "W:H:d:f:o:b")) != -1) {
+		switch (opt) {
+			case 'W': w = strtoul(optarg, NULL, 0); break;
+			case 'H': h = strtoul(optarg, NULL, 0); break;
+			case 'd': density = atoi(optarg); break;
+			case 'o': output = optarg; break;
+			case 'b': bench = 1; break;
+			case 'f':
+				for (i = 0; i < 3 && strcmp(optarg, format_names[i]); i++)
+					;
+				if (i == 3) {
+					usage();
+				}
+				format = i;
+				break;
+			default: usage();
+		}
+	}
+	if ((w % TORUS_TILE) || (h % TORUS_TILE) || density > 100) {
+		usage();
+	}
+	if (bench && optind == argc) {
+		return roundTrip(w ? w : 4096, h ? h : 4096, density);
+	}
+	if (optind != argc - 1) {
+		usage();
+	}
+
+	// size of the pattern (dry run without a target), unless given
+	if (patLoad(argv[optind], NULL, &info)) {
+		fprintf(stderr, "lifepat: %s\n", patError());
+		return 1;
+	}
+	t = torusCreate(w ? w : roundUp(info.width), h ? h : roundUp(info.height), 1);
+	if (!t) {
+		fprintf(stderr, "lifepat: out of memory\n");
+		return 1;
+	}
+	target = patTargetTorus(t);
+	time = now();
+	if (patLoad(argv[optind], &target, &info)) {
+		fprintf(stderr, "lifepat: %s\n", patError());
+		return 1;
+	}
+	time = now() - time;
+	printf("%s: %s%s%" PRIu32 "x%" PRIu32 ", %" PRIu64 " cells, rule %s, loaded in %.3f s\n", argv[optind],
+		info.name, info.name[0] ? ", " : "", info.width, info.height, info.cells,
+		info.rule[0] ? info.rule : "-", time);
+
+	if (bench) {
+		size_t size;
+		char* data = readFile(argv[optind], &size);
+
+		printf("parse: %.3f GB/s\n", parseSpeed(data, size, patFormat(argv[optind]), t) * 1e-9);
+		free(data);
+	}
+	if (output) {
+		if (format < 0 && (format = patFormat(output)) < 0) {
+			usage();
+		}
+		if (patSave(output, format, &target, &info)) {
+			fprintf(stderr, "lifepat: %s\n", patError());
+			return 1;
+		}
+	}
+	torusDestroy(t);
+	return 0;
+}
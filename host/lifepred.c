@@ -0,0 +1,533 @@
+/*
+ * lifepred.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Predecessor search: finds a world that evolves into a target
+					image after a given number of generations, so that the
+					firmware can start from a soup which "grows" a logo.
+					Reads the image (7 lines, '.' or ' ' = dead cell, any other
+					character = live cell) and prints the seed as a PROGMEM
+					array. -c searches n targets made from random seeds
+					instead, which all have a chain (regression check).
+Usage:				lifepred [-d depth] [-j threads] [-s seed] [-n name] [-c n] [image file]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "dot_matrix.h"
+#include "life.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define MAX_COLS		240				// DISP_MAX limit
+#define MAX_DEPTH		16
+#define COL_VALUES		(1 << DISP_ROWS)
+#define PAIRS			(COL_VALUES * COL_VALUES)
+#define TRIPLES			(PAIRS * COL_VALUES)
+#define CHECK_COLS		7				// width of the targets of the regression check
+
+
+/*********
+ * types *
+ *********/
+
+// The predecessor of world[level] is searched in world[level + 1] column by
+// column. Column x + 1 follows from columns x - 1, x and the target column x.
+typedef struct {
+	uint8_t world[MAX_DEPTH + 1][MAX_COLS];	// world[0] = target, world[depth] = seed
+	uint8_t* feasible[MAX_DEPTH];		// per level: see buildFeasible()
+	uint8_t last_ok[MAX_DEPTH][COL_VALUES];	// per level: last column closes the torus at column 0
+	uint32_t* dead[MAX_DEPTH];			// per level: memo of column pairs without completion, see extend()
+	uint32_t stamp;
+	uint32_t stills;					// number of still lifes rejected so far
+} search_t;
+
+
+/********************
+ * global variables *
+ ********************/
+
+static uint8_t next_col[TRIPLES];		// next state of column b, index = a << 14 | b << 7 | c
+static uint32_t cand_start[TRIPLES + 1];	// columns c with next_col(a, b, c) = out, index = a << 14 | b << 7 | out
+static uint8_t cand[TRIPLES];
+
+static uint8_t cols;
+static int depth = 1;
+static uint16_t pair_mul = 1, pair_add = 0;	// pair order (permutation of 0 .. PAIRS - 1)
+
+static atomic_uint next_pair;
+static atomic_int found;
+static pthread_mutex_t result_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t result[MAX_DEPTH + 1][MAX_COLS];
+
+// predecessor of a 7 column target at depth 2 that a prefix dependent memo missed
+static const uint8_t check_seed[CHECK_COLS] = {0x12, 0x62, 0x4c, 0x40, 0x42, 0x4b, 0x64};
+
+
+/**********
+ * makros *
+ **********/
+
+#define PAIR(a, b)			((uint16_t)(a) << DISP_ROWS | (b))
+#define TRIPLE(a, b, c)		((uint32_t)PAIR(a, b) << DISP_ROWS | (c))
+#define ORDER(i)			((uint16_t)((i) * pair_mul + pair_add) % PAIRS)
+
+
+/*************
+ * functions *
+ *************/
+
+/*======================================================================
+	Function:		buildTables
+	Input:			none
+	Output:			none
+	Description:	Tabulate the next state of a column for all neighbour
+					columns with the reference kernel (a torus of three
+					columns), and invert the table: for every pair of
+					columns and every output the list of right neighbours.
+======================================================================*/
+static void buildTables(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < TRIPLES; i++) {
+		uint8_t src[3] = {i >> 14, (i >> 7) & 0x7F, i & 0x7F};
+		uint8_t dst[3];
+
+		lifeStepRef(dst, src, 3);
+		next_col[i] = dst[1];
+		cand_start[TRIPLE(src[0], src[1], dst[1])]++;
+	}
+	for (i = 1; i <= TRIPLES; i++) {
+		cand_start[i] += cand_start[i - 1];	// end of every list
+	}
+	for (i = TRIPLES; i-- > 0; ) {
+		cand[--cand_start[TRIPLE(i >> 14, (i >> 7) & 0x7F, next_col[i])]] = i & 0x7F;
+	}
+}
+
+
+/*======================================================================
+	Function:		buildFeasible
+	Input:			table (cols * PAIRS bytes), target world
+	Output:			none
+	Description:	Constraint propagation from the right: feasible[x][a, b]
+					is set if columns a, b at x - 1, x can be continued up to
+					the last column of the world without contradicting the
+					target (ignoring the wrap-around to column 0). The
+					backtracking never enters a pair that is not feasible.
+======================================================================*/
+static void buildFeasible(uint8_t* feasible, const uint8_t* target)
+{
+	uint32_t ab, i;
+	int x;
+
+	for (ab = 0; ab < PAIRS; ab++) {
+		uint32_t key = (ab << DISP_ROWS) | target[cols - 1];
+
+		feasible[(cols - 1) * PAIRS + ab] = cand_start[key + 1] > cand_start[key];
+	}
+	for (x = cols - 2; x >= 1; x--) {
+		for (ab = 0; ab < PAIRS; ab++) {
+			uint32_t key = (ab << DISP_ROWS) | target[x];
+			uint8_t ok = 0;
+
+			for (i = cand_start[key]; i < cand_start[key + 1] && !ok; i++) {
+				ok = feasible[(x + 1) * PAIRS + PAIR(ab & 0x7F, cand[i])];
+			}
+			feasible[x * PAIRS + ab] = ok;
+		}
+	}
+}
+
+
+static int solveLevel(search_t* s, int level);
+
+
+/*======================================================================
+	Function:		extend
+	Input:			search state, level, column x (columns 0 .. x are set),
+					memo stamp of the current (target, column 0, column 1)
+	Output:			1 if a complete chain has been found
+	Description:	Backtracking over the columns of the predecessor. On the
+					last level the outcome for a given target and first two
+					columns only depends on columns x - 1 and x, so failed
+					pairs are memoized and never searched twice. Not so on
+					the other levels (the deeper levels search a predecessor
+					of the whole column vector) and not if a still life has
+					been rejected (a comparison with the whole prefix), so
+					these failures are not memoized.
+======================================================================*/
+static int extend(search_t* s, int level, uint8_t x, uint32_t stamp)
+{
+	const uint8_t* target = s->world[level];
+	uint8_t* p = s->world[level + 1];
+	uint32_t* dead = s->dead[level] ? &s->dead[level][x * PAIRS + PAIR(p[x - 1], p[x])] : NULL;
+	uint32_t stills = s->stills;
+	uint32_t key, n, i, first;
+
+	if (atomic_load_explicit(&found, memory_order_relaxed)) {
+		return 0;
+	}
+	if (x == cols - 1) {				// close the torus
+		if (next_col[TRIPLE(p[x - 1], p[x], p[0])] != target[x]
+				|| next_col[TRIPLE(p[x], p[0], p[1])] != target[0]) {
+			return 0;
+		}
+		if (!memcmp(p, target, cols)) {	// no still lifes
+			s->stills++;
+			return 0;
+		}
+		return (level + 1 == depth) ? 1 : solveLevel(s, level + 1);
+	}
+	if (dead && *dead == stamp) {
+		return 0;
+	}
+	key = TRIPLE(p[x - 1], p[x], target[x]);
+	n = cand_start[key + 1] - cand_start[key];
+	first = n ? (stamp + x) % n : 0;	// vary the order for random looking seeds
+	for (i = 0; i < n; i++) {
+		uint8_t c = cand[cand_start[key] + (first + i) % n];
+
+		if (!s->feasible[level][(x + 1) * PAIRS + PAIR(p[x], c)]) {
+			continue;
+		}
+		if (x + 2 == cols && !s->last_ok[level][c]) {
+			continue;
+		}
+		p[x + 1] = c;
+		if (extend(s, level, x + 1, stamp)) {
+			return 1;
+		}
+	}
+	if (dead && s->stills == stills) {
+		*dead = stamp;
+	}
+	return 0;
+}
+
+
+/*======================================================================
+	Function:		solvePair
+	Input:			search state, level, first two columns of the predecessor
+	Output:			1 if a complete chain has been found
+	Description:	.
+======================================================================*/
+static int solvePair(search_t* s, int level, uint16_t pair)
+{
+	uint8_t* p = s->world[level + 1];
+	uint8_t c;
+
+	if (!s->feasible[level][PAIRS + pair]) {
+		return 0;
+	}
+	p[0] = pair >> DISP_ROWS;
+	p[1] = pair & 0x7F;
+	for (c = 0; c < COL_VALUES; c++) {
+		s->last_ok[level][c] = (next_col[TRIPLE(c, p[0], p[1])] == s->world[level][0]);
+	}
+	return extend(s, level, 1, ++s->stamp);
+}
+
+
+// search a predecessor of world[level] (nested levels run in the calling thread)
+static int solveLevel(search_t* s, int level)
+{
+	uint32_t i;
+
+	buildFeasible(s->feasible[level], s->world[level]);
+	for (i = 0; i < PAIRS; i++) {
+		if (solvePair(s, level, ORDER(i))) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+static void* worker(void* arg)
+{
+	search_t* s = arg;
+	uint32_t i;
+
+	while (!atomic_load(&found) && (i = atomic_fetch_add(&next_pair, 1)) < PAIRS) {
+		if (solvePair(s, 0, ORDER(i))) {
+			pthread_mutex_lock(&result_lock);
+			if (!atomic_load(&found)) {
+				memcpy(result, s->world, sizeof(result));
+				atomic_store(&found, 1);
+			}
+			pthread_mutex_unlock(&result_lock);
+		}
+	}
+	return NULL;
+}
+
+
+/*======================================================================
+	Function:		search
+	Input:			search state of every thread, number of threads
+	Output:			1 if a chain has been found (in result)
+	Description:	Search a predecessor chain of the target in
+					s[0].world[0] with all threads.
+======================================================================*/
+static int search(search_t* s, int threads)
+{
+	pthread_t tid[256];
+	int i;
+
+	atomic_store(&next_pair, 0);
+	atomic_store(&found, 0);
+	for (i = 1; i < threads; i++) {
+		memcpy(s[i].world[0], s[0].world[0], MAX_COLS);
+	}
+	buildFeasible(s[0].feasible[0], s[0].world[0]);	// shared by all threads
+
+	for (i = 0; i < threads; i++) {
+		pthread_create(&tid[i], NULL, worker, &s[i]);
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(tid[i], NULL);
+	}
+	return atomic_load(&found);
+}
+
+
+// verify the chain in result with the reference kernel
+static int verify(void)
+{
+	uint8_t check[MAX_COLS], tmp[MAX_COLS];
+	int l;
+
+	memcpy(check, result[depth], cols);
+	for (l = depth - 1; l >= 0; l--) {
+		lifeStepRef(tmp, check, cols);
+		memcpy(check, tmp, cols);
+		if (memcmp(check, result[l], cols)) {
+			fprintf(stderr, "internal error: chain does not verify at level %d\n", l);
+			return 2;
+		}
+	}
+	return 0;
+}
+
+
+/*======================================================================
+	Function:		makeTarget
+	Input:			target (output), seed
+	Output:			1 if no generation of the chain is a still life
+	Description:	Run the seed for depth generations.
+======================================================================*/
+static int makeTarget(uint8_t* target, const uint8_t* seed)
+{
+	uint8_t tmp[MAX_COLS];
+	int l;
+
+	memcpy(target, seed, cols);
+	for (l = 0; l < depth; l++) {
+		lifeStepRef(tmp, target, cols);
+		if (!memcmp(tmp, target, cols)) {
+			return 0;
+		}
+		memcpy(target, tmp, cols);
+	}
+	return 1;
+}
+
+
+/*======================================================================
+	Function:		check
+	Input:			search state of every thread, number of threads,
+					number of random targets
+	Output:			0 if a chain has been found for every target
+	Description:	Regression check: every target is made by running a seed
+					for depth generations, so a chain exists and the search
+					must find one. The targets are check_seed and random
+					seeds of CHECK_COLS columns.
+======================================================================*/
+static int check(search_t* s, int threads, int count)
+{
+	uint8_t seed[MAX_COLS];
+	int n = 0, i, ok, tested = 0;
+	uint8_t x;
+
+	for (i = -1; i < count; i++) {
+		do {
+			for (x = 0; x < cols; x++) {
+				seed[x] = (i < 0) ? check_seed[x] : (rand() & 0x7F);
+			}
+			ok = makeTarget(s[0].world[0], seed);
+		} while (!ok && i >= 0);
+		if (!ok) {
+			continue;					// check_seed has a still life at this depth
+		}
+		tested++;
+		if (!search(s, threads)) {
+			fprintf(stderr, "no chain found for the target of the seed");
+			for (x = 0; x < cols; x++) {
+				fprintf(stderr, " 0x%02x", seed[x]);
+			}
+			fputc('\n', stderr);
+			n++;
+		}
+		else if (verify()) {
+			return 2;
+		}
+	}
+	printf("%d targets of depth %d: %s\n", tested, depth, n ? "FAILED" : "ok");
+	return n ? 1 : 0;
+}
+
+
+static int readImage(FILE* f, uint8_t* target)
+{
+	char line[MAX_COLS + 3];
+	int y = 0, x, len;
+
+	memset(target, 0, MAX_COLS);
+	cols = 0;
+	while (y < DISP_ROWS && fgets(line, sizeof(line), f)) {
+		len = strcspn(line, "\r\n");
+		for (x = 0; x < len && x < MAX_COLS; x++) {
+			if (line[x] != '.' && line[x] != ' ') {
+				target[x] |= 1 << y;
+			}
+		}
+		if (len > cols) {
+			cols = (len > MAX_COLS) ? MAX_COLS : len;
+		}
+		y++;
+	}
+	return (y == DISP_ROWS) && (cols >= 3);
+}
+
+
+static void printWorld(const uint8_t* w)
+{
+	int x, y;
+
+	for (y = 0; y < DISP_ROWS; y++) {
+		fprintf(stderr, "  ");
+		for (x = 0; x < cols; x++) {
+			fputc((w[x] >> y) & 1 ? '#' : '.', stderr);
+		}
+		fputc('\n', stderr);
+	}
+}
+
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: lifepred [-d depth] [-j threads] [-s seed] [-n name] [-c n] [image file]\n");
+	fprintf(stderr, "the image consists of %d lines of at least 3 characters, '.' or ' ' = dead cell\n", DISP_ROWS);
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	const char* name = "life_seed";
+	unsigned seed = 0;
+	search_t* s;
+	FILE* f = stdin;
+	int i, l, opt, check_count = 0;
+	uint8_t x;
+
+	while ((opt = getopt(argc, argv, "d:j:s:n:c:")) != -1) {
+		switch (opt) {
+			case 'd': depth = atoi(optarg); break;
+			case 'j': threads = atoi(optarg); break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			case 'n': name = optarg; break;
+			case 'c': check_count = atoi(optarg); break;
+			default: usage();
+		}
+	}
+	if (depth < 1 || depth > MAX_DEPTH || check_count < 0) {
+		usage();
+	}
+	if (threads < 1 || threads > 256) {
+		threads = 1;
+	}
+	if (optind < argc && !(f = fopen(argv[optind], "r"))) {
+		perror(argv[optind]);
+		return 2;
+	}
+	s = calloc(threads, sizeof(search_t));
+	if (!s) {
+		fprintf(stderr, "out of memory\n");
+		return 2;
+	}
+	if (check_count) {
+		cols = CHECK_COLS;
+		srand(seed);
+	}
+	else if (!readImage(f, s[0].world[0])) {
+		usage();
+	}
+	pair_mul = (seed * 2 + 1) & (PAIRS - 1);	// odd -> bijective
+	pair_add = (seed * 0x9E37) & (PAIRS - 1);
+
+	buildTables();
+	for (i = 0; i < threads; i++) {
+		for (l = 0; l < depth; l++) {
+			s[i].feasible[l] = (l == 0 && i > 0) ? s[0].feasible[0] : malloc(cols * PAIRS);
+		}
+		s[i].dead[depth - 1] = calloc(cols * PAIRS, sizeof(uint32_t));	// only the last level memoizes
+		if (!s[i].feasible[depth - 1] || !s[i].dead[depth - 1]) {
+			fprintf(stderr, "out of memory\n");
+			return 2;
+		}
+	}
+	if (check_count) {
+		return check(s, threads, check_count);
+	}
+
+	if (!search(s, threads)) {
+		fprintf(stderr, "no predecessor chain of depth %d exists\n", depth);
+		return 1;
+	}
+	if (verify()) {
+		return 2;
+	}
+
+	for (l = depth; l >= 0; l--) {
+		fprintf(stderr, "generation %d%s:\n", depth - l, l ? "" : " (target)");
+		printWorld(result[l]);
+	}
+	printf("// evolves into the target image after %d generations (lifepred)\n", depth);
+	printf("const uint8_t %s[%u] PROGMEM = {", name, cols);
+	for (x = 0; x < cols; x++) {
+		printf("%s0x%02x", x ? ", " : "", result[depth][x]);
+	}
+	printf("};\n");
+	return 0;
+}
@@ -0,0 +1,508 @@
+/*
+ * liferules.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Explores all 2^18 outer totalistic rules (B/S) on the 5x7
+					torus of the display. Every rule runs the same random soups
+					(dmWakeUp() style) until each soup has entered a cycle, and
+					is characterised by the mean transient length, the
+					distribution of the cycle lengths and the activity (changed
+					cells per cell and generation). The results are kept in a
+					cache file, so an interrupted sweep is resumed where it
+					stopped. Prints the best ranked rules as life_rules.h for
+					the firmware (see LIFE_RULE_TABLE in life.h).
+Usage:				liferules [-c cache] [-n soups] [-g generations] [-j threads]
+					[-s seed] [-t table size] [-v]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "dot_matrix.h"
+#include "life.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define COLS			DISP_COLUMNS
+#define ROWS			DISP_ROWS
+#define CELLS			(COLS * ROWS)
+#define LANES			64				// soups stepped at once (1 bit per soup in every cell word)
+#define RULES			(1L << 18)		// bits 0..8 = birth, bits 9..17 = survival
+#define CHUNK			256				// rules per work item and cache write
+#define MAX_GENS		4096
+#define PERIOD_BINS		8				// cycle length 1, 2, 3-4, 5-8, 9-16, 17-32, 33-64, > 64
+#define CACHE_MAGIC		0x53454C5552584548ULL	// "HXRULES"
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	uint64_t magic;
+	uint32_t soups, gens, seed;
+	uint32_t reserved;
+} cache_header_t;
+
+typedef struct {
+	uint32_t done;
+	uint32_t dead;						// soups that died out
+	uint32_t unfinished;				// soups without a cycle after 'gens' generations
+	uint32_t period[PERIOD_BINS];		// cycle length distribution of the other soups
+	float transient;					// mean number of generations before the cycle
+	float activity;						// changed cells per cell and generation
+} rule_stats_t;
+
+typedef struct {
+	uint64_t cell[CELLS];				// bit n = cell of soup n
+} batch_t;
+
+
+/********************
+ * global variables *
+ ********************/
+
+static uint32_t soups = 256, gens = 1024, seed = 1;
+static batch_t* start;					// initial soups, soups / LANES batches
+static rule_stats_t* stats;
+static int cache_fd = -1;
+static atomic_long next_chunk;
+static atomic_long chunks_done;
+
+
+/*************
+ * functions *
+ *************/
+
+/*======================================================================
+	Function:		makeSoups
+	Input:			none
+	Output:			none
+	Description:	Fill the soups like dmWakeUp() (every column = rand() %
+					0x80) and transpose them into batches of 64 soups.
+======================================================================*/
+static void makeSoups(void)
+{
+	uint32_t s, x, y;
+
+	srand(seed);
+	for (s = 0; s < soups; s++) {
+		batch_t* b = &start[s / LANES];
+
+		for (x = 0; x < COLS; x++) {
+			uint8_t col = rand() % 0x80;
+
+			for (y = 0; y < ROWS; y++) {
+				if ((col >> y) & 1) {
+					b->cell[y * COLS + x] |= 1ULL << (s % LANES);
+				}
+			}
+		}
+	}
+}
+
+
+/*======================================================================
+	Function:		stepBatch
+	Input:			next generation, current generation, rule masks
+					(bit k = a cell with k live cells in its 3x3 block,
+					including itself, is alive in the next generation)
+	Output:			none
+	Description:	Bit sliced generation of 64 soups. The 3x3 sum (0..9)
+					is built from vertical sums of three cells and compared
+					against every value the rule cares about.
+======================================================================*/
+static void stepBatch(batch_t* dst, const batch_t* src, uint16_t born, uint16_t keep)
+{
+	uint64_t v0[CELLS], v1[CELLS];
+	int x, y, k;
+
+	for (y = 0; y < ROWS; y++) {
+		const uint64_t* u = &src->cell[((y + ROWS - 1) % ROWS) * COLS];
+		const uint64_t* c = &src->cell[y * COLS];
+		const uint64_t* d = &src->cell[((y + 1) % ROWS) * COLS];
+
+		for (x = 0; x < COLS; x++) {
+			v0[y * COLS + x] = u[x] ^ c[x] ^ d[x];
+			v1[y * COLS + x] = (u[x] & c[x]) | (d[x] & (u[x] ^ c[x]));
+		}
+	}
+	for (y = 0; y < ROWS; y++) {
+		for (x = 0; x < COLS; x++) {
+			int l = y * COLS + (x + COLS - 1) % COLS, m = y * COLS + x, r = y * COLS + (x + 1) % COLS;
+			uint64_t s0 = v0[l] ^ v0[m] ^ v0[r];
+			uint64_t k1 = (v0[l] & v0[m]) | (v0[r] & (v0[l] ^ v0[m]));
+			uint64_t a = v1[l], b = v1[m], c = v1[r];
+			// 3x3 sum = s0 + 2 * s1 + 4 * s2 + 8 * s3, a, b, c and k1 have weight 2
+			uint64_t ab = a ^ b, cd = c ^ k1;
+			uint64_t s1 = ab ^ cd;
+			uint64_t c1 = (a & b) | (c & k1), c2 = ab & cd;
+			uint64_t s3 = a & b & c & k1;	// c1 counts twice
+			uint64_t s2 = (c1 | c2) & ~s3;
+			uint64_t centre = src->cell[m];
+			uint64_t next = 0;
+
+			for (k = 0; k <= 9; k++) {
+				uint64_t eq, alive;
+
+				alive = ((born >> k) & 1 ? ~centre : 0) | ((keep >> k) & 1 ? centre : 0);
+				if (!alive) {
+					continue;
+				}
+				eq = ((k & 1) ? s0 : ~s0) & ((k & 2) ? s1 : ~s1)
+					& ((k & 4) ? s2 : ~s2) & ((k & 8) ? s3 : ~s3);
+				next |= eq & alive;
+			}
+			dst->cell[m] = next;
+		}
+	}
+}
+
+
+static int laneEqual(const batch_t* a, const batch_t* b, int lane)
+{
+	int i;
+
+	for (i = 0; i < CELLS; i++) {
+		if (((a->cell[i] ^ b->cell[i]) >> lane) & 1) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+/*======================================================================
+	Function:		runRule
+	Input:			rule, history buffer (gens + 1 batches)
+	Output:			statistics
+	Description:	Brent's cycle detection for all lanes at once: the
+					state at generation 1, 2, 4, 8, ... is kept, and a lane
+					whose state equals it has found its cycle length. The
+					transient is then looked up in the history. Lanes leave
+					the batch as soon as their cycle is known, and the batch
+					stops when all lanes are done.
+======================================================================*/
+static void runRule(uint32_t rule, batch_t* hist, rule_stats_t* st)
+{
+	// rule masks in terms of the 3x3 sum: born with n neighbours = sum n, survive = sum n + 1
+	uint16_t born = rule & 0x1FF, keep = ((rule >> 9) & 0x1FF) << 1;
+	double transient = 0, changed = 0, lane_gens = 0;
+	uint32_t b, finished = 0;
+	int i;
+
+	memset(st, 0, sizeof(*st));
+	for (b = 0; b < soups / LANES; b++) {
+		uint64_t active = ~0ULL;
+		batch_t snap = start[b];
+		uint32_t snap_gen = 0, power = 1, g;
+
+		hist[0] = start[b];
+		for (g = 1; g <= gens && active; g++) {
+			uint64_t eq = active;
+
+			stepBatch(&hist[g], &hist[g - 1], born, keep);
+			for (i = 0; i < CELLS; i++) {
+				eq &= ~(hist[g].cell[i] ^ snap.cell[i]);
+				changed += __builtin_popcountll((hist[g].cell[i] ^ hist[g - 1].cell[i]) & active);
+			}
+			lane_gens += __builtin_popcountll(active);
+			while (eq) {
+				int lane = __builtin_ctzll(eq);
+				uint32_t period = g - snap_gen, t = 0, bin = 0, alive = 0;
+
+				while (!laneEqual(&hist[t], &hist[t + period], lane)) {
+					t++;
+				}
+				for (i = 0; i < CELLS; i++) {
+					alive |= (hist[g].cell[i] >> lane) & 1;
+				}
+				if (!alive) {
+					st->dead++;
+				}
+				else {
+					while (bin < PERIOD_BINS - 1 && period > (1U << bin)) {
+						bin++;
+					}
+					st->period[bin]++;
+				}
+				transient += t;
+				finished++;
+				eq &= eq - 1;
+				active &= ~(1ULL << lane);
+			}
+			if (g - snap_gen == power) {
+				snap = hist[g];
+				snap_gen = g;
+				power *= 2;
+			}
+		}
+		st->unfinished += __builtin_popcountll(active);
+	}
+	st->transient = finished ? transient / finished : 0;
+	st->activity = lane_gens ? changed / lane_gens / CELLS : 0;
+	st->done = 1;
+}
+
+
+/*======================================================================
+	Function:		checkStepper
+	Input:			none
+	Output:			0 if the bit sliced stepper agrees with lifeStepRef
+	Description:	Runs the first batch of soups with the rule compiled
+					into the firmware (life.h) and compares every soup with
+					the reference kernel.
+======================================================================*/
+static int checkStepper(void)
+{
+	uint32_t rule = LIFE_BIRTH | (uint32_t)LIFE_SURVIVE << 9;
+	batch_t cur = start[0], next;
+	uint8_t world[LANES][COLS], tmp[COLS];
+	int g, lane, x, y;
+
+	for (lane = 0; lane < LANES; lane++) {
+		for (x = 0; x < COLS; x++) {
+			world[lane][x] = 0;
+			for (y = 0; y < ROWS; y++) {
+				world[lane][x] |= ((cur.cell[y * COLS + x] >> lane) & 1) << y;
+			}
+		}
+	}
+	for (g = 0; g < 64; g++) {
+		stepBatch(&next, &cur, rule & 0x1FF, ((rule >> 9) & 0x1FF) << 1);
+		cur = next;
+		for (lane = 0; lane < LANES; lane++) {
+			lifeStepRef(tmp, world[lane], COLS);
+			memcpy(world[lane], tmp, COLS);
+			for (x = 0; x < COLS; x++) {
+				for (y = 0; y < ROWS; y++) {
+					if (((cur.cell[y * COLS + x] >> lane) & 1) != ((tmp[x] >> y) & 1)) {
+						fprintf(stderr, "stepper differs from lifeStepRef in generation %d\n", g + 1);
+						return 1;
+					}
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+
+static void* worker(void* arg)
+{
+	batch_t* hist = malloc((gens + 1) * sizeof(batch_t));
+	long chunk;
+	uint32_t r;
+
+	while ((chunk = atomic_fetch_add(&next_chunk, 1)) < RULES / CHUNK) {
+		rule_stats_t* st = &stats[chunk * CHUNK];
+
+		if (st->done) {
+			continue;					// cached
+		}
+		for (r = 0; r < CHUNK; r++) {
+			runRule(chunk * CHUNK + r, hist, &st[r]);
+		}
+		if (cache_fd >= 0) {
+			pwrite(cache_fd, st, CHUNK * sizeof(rule_stats_t),
+				sizeof(cache_header_t) + chunk * CHUNK * sizeof(rule_stats_t));
+		}
+		if (atomic_fetch_add(&chunks_done, 1) % 64 == 63) {
+			fprintf(stderr, "\r%ld / %ld", atomic_load(&chunks_done), RULES / CHUNK);
+		}
+	}
+	free(hist);
+	return NULL;
+}
+
+
+/*======================================================================
+	Function:		openCache
+	Input:			file name
+	Output:			none
+	Description:	Load the results of an earlier sweep with the same
+					parameters, or start a new cache file.
+======================================================================*/
+static void openCache(const char* name)
+{
+	cache_header_t want = {CACHE_MAGIC, soups, gens, seed, 0}, have;
+
+	cache_fd = open(name, O_RDWR | O_CREAT, 0644);
+	if (cache_fd < 0) {
+		perror(name);
+		exit(2);
+	}
+	if (pread(cache_fd, &have, sizeof(have), 0) == sizeof(have) && !memcmp(&have, &want, sizeof(want))) {
+		if (pread(cache_fd, stats, RULES * sizeof(rule_stats_t), sizeof(have)) < 0) {
+			memset(stats, 0, RULES * sizeof(rule_stats_t));
+		}
+		return;
+	}
+	if (ftruncate(cache_fd, 0) || pwrite(cache_fd, &want, sizeof(want), 0) != sizeof(want)) {
+		perror(name);
+		exit(2);
+	}
+}
+
+
+// higher = more interesting: long and active transients, few soups dying or running forever
+static double score(const rule_stats_t* st)
+{
+	if ((st - stats) & 1) {
+		return 0;						// B0: every empty cell is born, the display flashes
+	}
+	return st->transient * st->activity
+		* (1.0 - (double)st->dead / soups) * (1.0 - (double)st->unfinished / soups);
+}
+
+
+static int compareRules(const void* a, const void* b)
+{
+	double sa = score(&stats[*(const uint32_t*)a]), sb = score(&stats[*(const uint32_t*)b]);
+
+	return (sa < sb) - (sa > sb);
+}
+
+
+static void printRule(char* buf, uint32_t rule)
+{
+	int n;
+
+	buf += sprintf(buf, "B");
+	for (n = 0; n <= 8; n++) {
+		if ((rule >> n) & 1) {
+			buf += sprintf(buf, "%d", n);
+		}
+	}
+	buf += sprintf(buf, "/S");
+	for (n = 0; n <= 8; n++) {
+		if ((rule >> (9 + n)) & 1) {
+			buf += sprintf(buf, "%d", n);
+		}
+	}
+}
+
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: liferules [-c cache] [-n soups] [-g generations] [-j threads] [-s seed] [-t table size] [-v]\n");
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	const char* cache = "liferules.cache";
+	uint32_t table = 16, verbose = 0;
+	uint32_t* order;
+	pthread_t tid[256];
+	uint32_t i, j;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:n:g:j:s:t:v")) != -1) {
+		switch (opt) {
+			case 'c': cache = optarg; break;
+			case 'n': soups = strtoul(optarg, NULL, 0); break;
+			case 'g': gens = strtoul(optarg, NULL, 0); break;
+			case 'j': threads = atoi(optarg); break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			case 't': table = strtoul(optarg, NULL, 0); break;
+			case 'v': verbose = 1; break;
+			default: usage();
+		}
+	}
+	if (soups == 0 || soups % LANES || gens == 0 || gens > MAX_GENS || table == 0 || table > 256) {
+		usage();
+	}
+	if (threads < 1 || threads > 256) {
+		threads = 1;
+	}
+	start = calloc(soups / LANES, sizeof(batch_t));
+	stats = calloc(RULES, sizeof(rule_stats_t));
+	order = malloc(RULES * sizeof(uint32_t));
+	if (!start || !stats || !order) {
+		fprintf(stderr, "out of memory\n");
+		return 2;
+	}
+	makeSoups();
+	if (checkStepper()) {
+		return 2;
+	}
+	if (*cache) {
+		openCache(cache);
+	}
+
+	for (i = 0; i < (uint32_t)threads; i++) {
+		pthread_create(&tid[i], NULL, worker, NULL);
+	}
+	for (i = 0; i < (uint32_t)threads; i++) {
+		pthread_join(tid[i], NULL);
+	}
+	fprintf(stderr, "\r");
+
+	for (i = 0; i < RULES; i++) {
+		order[i] = i;
+	}
+	qsort(order, RULES, sizeof(uint32_t), compareRules);
+
+	printf("// generated by liferules -n %u -g %u -s %u: the %u best ranked rules of the 5x7 torus\n",
+		soups, gens, seed, table);
+	printf("// score = mean transient * activity * (1 - dead soups) * (1 - soups without a cycle), B0 rules excluded\n");
+	printf("#define LIFE_RULES\t\t%u\n\n", table);
+	printf("const uint16_t life_rules[LIFE_RULES][2] PROGMEM = {\t// birth and survival masks\n");
+	for (i = 0; i < table; i++) {
+		const rule_stats_t* st = &stats[order[i]];
+		char name[32];
+
+		printRule(name, order[i]);
+		printf("\t{0x%03x, 0x%03x},\t// %-16s score %6.2f, transient %6.1f, activity %.3f\n",
+			order[i] & 0x1FF, order[i] >> 9, name, score(st), st->transient, st->activity);
+	}
+	printf("};\n");
+
+	if (verbose) {
+		fprintf(stderr, "%-20s %8s %10s %8s %6s %6s  cycle lengths 1 2 3-4 5-8 9-16 17-32 33-64 >64\n",
+			"rule", "score", "transient", "activity", "dead", "open");
+		for (i = 0; i < table; i++) {
+			const rule_stats_t* st = &stats[order[i]];
+			char name[32];
+
+			printRule(name, order[i]);
+			fprintf(stderr, "%-20s %8.2f %10.1f %8.3f %6u %6u ", name, score(st),
+				st->transient, st->activity, st->dead, st->unfinished);
+			for (j = 0; j < PERIOD_BINS; j++) {
+				fprintf(stderr, " %u", st->period[j]);
+			}
+			fprintf(stderr, "\n");
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * lifestream.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Drives a Hacklace in streaming mode (STREAM in config.h, see
+					stream.h): a viewport of DISP_MAX x DISP_ROWS cells of a
+					large torus, computed by the tiled engine of torus.c,
+					is sent as one packet per frame to a serial device, a file
+					or stdout. The viewport can pan over the torus. A serial
+					device is switched to raw mode at the baud rate of the
+					firmware. -e damages the checksum of every n-th packet to
+					test the error handling (e.g. with lifeemu -S).
+Usage:				lifestream [-W width] [-H height] [-j threads] [-d density]
+					[-s seed] [-l pattern] [-x column] [-y row] [-p pan]
+					[-g generations per frame] [-f frames/s] [-n frames]
+					[-b baud] [-e n] [-o output]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "config.h"
+#include "dot_matrix.h"
+#include "stream.h"
+#include "torus.h"
+#include "patio.h"
+
+
+/*************
+ * functions *
+ *************/
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "lifestream: %s\n", msg);
+	exit(1);
+}
+
+
+static void randomize(torus_t* t, unsigned density, unsigned seed)
+{
+	uint32_t x, y;
+
+	srand(seed);
+	for (x = 0; x < torusWidth(t); x++) {
+		for (y = 0; y < torusHeight(t); y++) {
+			torusSetCell(t, x, y, (unsigned)(rand() % 100) < density);
+		}
+	}
+}
+
+
+static speed_t baudConstant(long baud)
+{
+	static const struct {
+		long baud;
+		speed_t speed;
+	} speeds[] = {
+		{9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600},
+		{115200, B115200}, {230400, B230400}, {0, 0}
+	};
+	int i;
+
+	for (i = 0; speeds[i].baud; i++) {
+		if (speeds[i].baud == baud) {
+			return speeds[i].speed;
+		}
+	}
+	fail("unsupported baud rate");
+	return 0;
+}
+
+
+/*======================================================================
+	Function:		openOutput
+	Input:			file name (NULL = stdout), baud rate
+	Output:			file descriptor
+	Description:	A terminal device is set to raw 8N1 at the baud rate,
+					anything else is written as is.
+======================================================================*/
+static int openOutput(const char* file, long baud)
+{
+	struct termios tio;
+	int fd = STDOUT_FILENO;
+
+	if (file && (fd = open(file, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644)) < 0) {
+		perror(file);
+		exit(1);
+	}
+	if (isatty(fd)) {
+		if (tcgetattr(fd, &tio)) {
+			fail("cannot read the terminal settings");
+		}
+		cfmakeraw(&tio);
+		tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+		tio.c_cflag |= CLOCAL;
+		cfsetospeed(&tio, baudConstant(baud));
+		cfsetispeed(&tio, baudConstant(baud));
+		if (tcsetattr(fd, TCSANOW, &tio)) {
+			fail("cannot set the baud rate");
+		}
+	}
+	return fd;
+}
+
+
+static void writeAll(int fd, const uint8_t* buf, size_t len)
+{
+	ssize_t n;
+
+	while (len) {
+		if ((n = write(fd, buf, len)) <= 0) {
+			perror("lifestream");
+			exit(1);
+		}
+		buf += n;
+		len -= n;
+	}
+}
+
+
+/*======================================================================
+	Function:		encode
+	Input:			packet (STREAM_PACKET bytes, output), torus, viewport
+					position
+	Output:			none
+	Description:	Sync byte, the DISP_MAX columns of the viewport (bit y =
+					row y) and the checksum of stream.h.
+======================================================================*/
+static void encode(uint8_t* packet, const torus_t* t, uint32_t x0, uint32_t y0)
+{
+	uint32_t w = torusWidth(t), h = torusHeight(t);
+	uint8_t sum = 0, col;
+	int x, y;
+
+	packet[0] = STREAM_SYNC;
+	for (x = 0; x < DISP_MAX; x++) {
+		col = 0;
+		for (y = 0; y < DISP_ROWS; y++) {
+			col |= torusGetCell(t, (x0 + x) % w, (y0 + y) % h) << y;
+		}
+		packet[1 + x] = col;
+		sum = STREAM_SUM(sum, col);
+	}
+	packet[1 + DISP_MAX] = sum;
+}
+
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: lifestream [-W width] [-H height] [-j threads] [-d density] [-s seed] [-l pattern]\n");
+	fprintf(stderr, "                  [-x column] [-y row] [-p pan] [-g generations per frame] [-f frames/s]\n");
+	fprintf(stderr, "                  [-n frames] [-b baud] [-e n] [-o output]\n");
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	uint32_t w = 1024, h = 1024, x, y;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned density = 30, seed = 1;
+	const char* pattern = NULL;
+	const char* output = NULL;
+	long x0 = 0, y0 = 0, pan = 0, per_frame = 1, frames = 0, damage = 0, baud = STREAM_BAUD, frame;
+	double fps = 25, next, start;
+	uint8_t packet[STREAM_PACKET];
+	torus_t* t;
+	int fd, opt;
+
+	while ((opt = getopt(argc, argv, "W:H:j:d:s:l:x:y:p:g:f:n:b:e:o:")) != -1) {
+		switch (opt) {
+			case 'W': w = strtoul(optarg, NULL, 0); break;
+			case 'H': h = strtoul(optarg, NULL, 0); break;
+			case 'j': threads = atoi(optarg); break;
+			case 'd': density = atoi(optarg); break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			case 'l': pattern = optarg; break;
+			case 'x': x0 = atol(optarg); break;
+			case 'y': y0 = atol(optarg); break;
+			case 'p': pan = atol(optarg); break;
+			case 'g': per_frame = atol(optarg); break;
+			case 'f': fps = atof(optarg); break;
+			case 'n': frames = atol(optarg); break;
+			case 'b': baud = atol(optarg); break;
+			case 'e': damage = atol(optarg); break;
+			case 'o': output = optarg; break;
+			default: usage();
+		}
+	}
+	if (optind != argc || per_frame < 0 || fps < 0 || frames < 0 || damage < 0) {
+		usage();
+	}
+	if (threads < 1 || threads > 256) {
+		threads = 1;
+	}
+	if (!(t = torusCreate(w, h, threads))) {
+		usage();
+	}
+	x = ((x0 % (long)w) + w) % w;
+	y = ((y0 % (long)h) + h) % h;
+	if (pattern) {
+		pat_target_t target = patTargetTorus(t);
+		pat_info_t info;
+
+		target.x = x;						// top left corner of the viewport
+		target.y = y;
+		if (patLoad(pattern, &target, &info)) {
+			fail(patError());
+		}
+	}
+	else {
+		randomize(t, density, seed);
+	}
+	if (fps * STREAM_PACKET * 10 > baud) {
+		fprintf(stderr, "lifestream: %ld baud carry only %.0f frames/s\n", baud, (double)baud / 10 / STREAM_PACKET);
+	}
+
+	fd = openOutput(output, baud);
+	start = next = now();
+	for (frame = 0; !frames || frame < frames; frame++) {
+		encode(packet, t, x, y);
+		if (damage && frame % damage == damage - 1) {
+			packet[1 + DISP_MAX] ^= 1;		// wrong checksum
+		}
+		writeAll(fd, packet, sizeof(packet));
+		torusStep(t, per_frame);
+		x = (uint32_t)(((x + pan) % (long)w + w) % w);
+		if (fps) {
+			next += 1.0 / fps;
+			while (now() < next) {
+				usleep((useconds_t)((next - now()) * 1e6) + 1);
+			}
+		}
+	}
+	if (isatty(fd)) {
+		tcdrain(fd);
+	}
+	fprintf(stderr, "lifestream: %ld frames, %ld bytes in %.1f s, generation %" PRIu64 ", %" PRIu64 " cells alive\n",
+		frame, frame * (long)sizeof(packet), now() - start, torusGeneration(t), torusPopulation(t));
+	torusDestroy(t);
+	return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * lifetorus.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Runs the tiled torus engine (torus.c) on a random soup and
+					prints the speed in generations and cells per second.
+					With -c the engine is compared against a plain cell by
+					cell implementation first, on two small tori as a smoke
+					test and on the -W x -H torus itself.
+Usage:				lifetorus [-W width] [-H height] [-j threads] [-g generations]
+					[-d density] [-s seed] [-c check generations]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "torus.h"
+
+
+/*************
+ * functions *
+ *************/
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static void randomize(torus_t* t, unsigned density, unsigned seed)
+{
+	uint32_t x, y;
+
+	srand(seed);
+	for (x = 0; x < torusWidth(t); x++) {
+		for (y = 0; y < torusHeight(t); y++) {
+			torusSetCell(t, x, y, (unsigned)(rand() % 100) < density);
+		}
+	}
+}
+
+
+/*======================================================================
+	Function:		check
+	Input:			width, height, generations, density, seed, threads
+	Output:			0 if the engine matches the plain implementation
+	Description:	Run the engine and a cell by cell implementation of
+					Conway's rule side by side.
+======================================================================*/
+static int check(uint32_t w, uint32_t h, long gens, unsigned density, unsigned seed, int threads)
+{
+	torus_t* t = torusCreate(w, h, threads);
+	uint8_t* a = malloc((size_t)w * h);
+	uint8_t* b = malloc((size_t)w * h);
+	uint32_t x, y;
+	long g;
+
+	if (!t || !a || !b) {
+		fprintf(stderr, "cannot create a %ux%u torus\n", w, h);
+		return 1;
+	}
+	randomize(t, density, seed);
+	for (x = 0; x < w; x++) {
+		for (y = 0; y < h; y++) {
+			a[(size_t)y * w + x] = torusGetCell(t, x, y);
+		}
+	}
+	for (g = 1; g <= gens; g++) {
+		uint8_t* tmp;
+
+		for (y = 0; y < h; y++) {
+			for (x = 0; x < w; x++) {
+				int n = 0, dx, dy;
+
+				for (dy = -1; dy <= 1; dy++) {
+					for (dx = -1; dx <= 1; dx++) {
+						if (dx || dy) {
+							n += a[(size_t)((y + h + dy) % h) * w + (x + w + dx) % w];
+						}
+					}
+				}
+				b[(size_t)y * w + x] = (n == 3) || (n == 2 && a[(size_t)y * w + x]);
+			}
+		}
+		tmp = a;  a = b;  b = tmp;
+		torusStep(t, 1);
+		for (y = 0; y < h; y++) {
+			for (x = 0; x < w; x++) {
+				if (torusGetCell(t, x, y) != a[(size_t)y * w + x]) {
+					printf("mismatch in generation %ld at (%u, %u)\n", g, x, y);
+					return 1;
+				}
+			}
+		}
+	}
+	printf("%ux%u torus: %ld generations ok (%" PRIu64 " cells alive, %u active tiles)\n",
+		w, h, gens, torusPopulation(t), torusActiveTiles(t));
+	torusDestroy(t);
+	free(a);
+	free(b);
+	return 0;
+}
+
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: lifetorus [-W width] [-H height] [-j threads] [-g generations] [-d density] [-s seed] [-c check generations]\n");
+	fprintf(stderr, "width and height must be multiples of %d\n", TORUS_TILE);
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	uint32_t w = 4096, h = 4096;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	long gens = 100, check_gens = 0;
+	unsigned density = 30, seed = 1;
+	uint64_t active = 0;
+	torus_t* t;
+	double time;
+	long g;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "W:H:j:g:d:s:c:")) != -1) {
+		switch (opt) {
+			case 'W': w = strtoul(optarg, NULL, 0); break;
+			case 'H': h = strtoul(optarg, NULL, 0); break;
+			case 'j': threads = atoi(optarg); break;
+			case 'g': gens = atol(optarg); break;
+			case 'd': density = atoi(optarg); break;
+			case 's': seed = strtoul(optarg, NULL, 0); break;
+			case 'c': check_gens = atol(optarg); break;
+			default: usage();
+		}
+	}
+	if (threads < 1 || threads > 256) {
+		threads = 1;
+	}
+	if (check_gens) {
+		// small worlds with a few tiles first, then the geometry of the run
+		if (check(4 * TORUS_TILE, 3 * TORUS_TILE, check_gens, density, seed, threads)
+				|| check(TORUS_TILE, TORUS_TILE, check_gens, density, seed, threads)
+				|| check(w, h, check_gens, density, seed, threads)) {
+			return 1;
+		}
+	}
+
+	t = torusCreate(w, h, threads);
+	if (!t) {
+		usage();
+	}
+	randomize(t, density, seed);
+	time = now();
+	for (g = 0; g < gens; g++) {
+		torusStep(t, 1);
+		active += torusActiveTiles(t);
+	}
+	time = now() - time;
+	printf("%ux%u torus, %d threads: %.1f generations/s, %.3f Gcells/s, %.0f%% tiles active, %" PRIu64 " cells alive\n",
+		w, h, threads, gens / time, (double)w * h * gens / time * 1e-9,
+		100.0 * active / gens / ((w / TORUS_TILE) * (h / TORUS_TILE)), torusPopulation(t));
+	torusDestroy(t);
+	return 0;
+}
@@ -0,0 +1,372 @@
+/*
+ * lifetrace.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Records the firmware loop (generation, still life
+					detection and reseeding of dmScroll) as a frame trace
+					(trace.h) and replays traces: summary, any frame by
+					random access, the reseed events with their cause and
+					the frames in which two traces differ, e.g. of two
+					kernels.
+Usage:				lifetrace -r trace [-k kernel] [-g generations] [-s seed]
+					[-w columns] [-i keyframe interval]
+					lifetrace [-f first frame] [-n frames] [-e] [-d other trace] trace
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "dot_matrix.h"
+#include "life.h"
+#include "kernels.h"
+#include "trace.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define SEEKS			1000			// random accesses timed by the summary
+
+
+/*************
+ * functions *
+ *************/
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "lifetrace: %s\n", msg);
+	exit(1);
+}
+
+
+// new world like dmWakeUp()
+static void seedWorld(uint8_t* world, uint8_t cols)
+{
+	uint8_t x;
+
+	for (x = 0; x < cols; x++) {
+		world[x] = rand() % (1 << DISP_ROWS);
+	}
+}
+
+
+/*======================================================================
+	Function:		record
+	Input:			trace file, kernel, generations, seed, columns,
+					frames per keyframe
+	Output:			none
+	Description:	Run the loop of dmScroll (see also runFirmware in
+					lifecheck.c) with the given kernel and store every
+					frame: a frame is seeded instead of computed when
+					lifeReseedDue() says so.
+======================================================================*/
+static void record(const char* file, const kernel_t* k, uint64_t gens, unsigned seed, uint8_t cols, uint32_t interval)
+{
+	uint8_t world[TRACE_MAX_COLS], next[TRACE_MAX_COLS];
+	uint64_t frames = gens / k->gens, g, reseeds = 0;
+	trace_info_t info;
+	trace_t* t;
+	double start = now();
+	uint8_t reseed;
+
+	if (!(t = traceCreate(file, cols, DISP_ROWS, k->gens, interval))) {
+		fail(traceError());
+	}
+	srand(seed);
+	lifeResetCounters();
+	seedWorld(world, cols);
+	if (traceAppend(t, world, 1)) {
+		fail(traceError());
+	}
+	for (g = 1; g < frames; g++) {
+		k->step(next, world, cols);
+		reseed = lifeReseedDue(memcmp(next, world, cols) == 0);
+		if (reseed) {
+			seedWorld(next, cols);
+			reseeds++;
+		}
+		memcpy(world, next, cols);
+		if (traceAppend(t, world, reseed)) {
+			fail(traceError());
+		}
+	}
+	if (traceClose(t)) {
+		fail(traceError());
+	}
+	if (!(t = traceOpen(file))) {				// read back the size and check the index
+		fail(traceError());
+	}
+	traceInfo(t, &info);
+	traceClose(t);
+	printf("kernel %s: %" PRIu64 " frames, %" PRIu64 " reseeds, %.1f s (%.2f M frames/s)\n",
+		k->name, frames, reseeds, now() - start, frames / (now() - start) * 1e-6);
+	printf("%s: %" PRIu64 " bytes, %.4f bits per frame\n", file, info.bytes, info.bytes * 8.0 / frames);
+}
+
+
+static void printFrames(const uint8_t* a, const uint8_t* b, const trace_info_t* info)
+{
+	uint8_t x, y;
+
+	for (y = 0; y < info->rows; y++) {
+		for (x = 0; x < info->cols; x++) {
+			putchar((a[x] >> y) & 1 ? 'O' : '.');
+		}
+		if (b) {
+			printf("   ");
+			for (x = 0; x < info->cols; x++) {
+				putchar((b[x] >> y) & 1 ? 'O' : '.');
+			}
+		}
+		putchar('\n');
+	}
+}
+
+
+static void summary(const char* file, trace_t* t, const trace_info_t* info)
+{
+	uint8_t frame[TRACE_MAX_COLS];
+	double start;
+	int i;
+
+	printf("%s: %u x %u cells, %" PRIu64 " frames of %u generation%s, keyframe every %u frames\n",
+		file, info->cols, info->rows, info->frames, info->gens, (info->gens == 1) ? "" : "s", info->interval);
+	printf("%" PRIu64 " bytes, %.4f bits per frame\n", info->bytes, info->frames ? info->bytes * 8.0 / info->frames : 0);
+	if (!info->frames) {
+		return;
+	}
+	srand(1);
+	start = now();
+	for (i = 0; i < SEEKS; i++) {
+		traceSeek(t, ((uint64_t)rand() * RAND_MAX + rand()) % info->frames);
+		traceNext(t, frame, NULL);
+	}
+	printf("random access: %.1f us per frame\n", (now() - start) * 1e6 / SEEKS);
+}
+
+
+/*======================================================================
+	Function:		events
+	Input:			trace, first frame, number of frames
+	Output:			none
+	Description:	List the reseeds: after a still life (the frame before
+					was equal to its predecessor) or after the number of
+					frames since the previous reseed, which shows the
+					counters samecnt and animcnt of lifeReseedDue() at work.
+======================================================================*/
+static void events(trace_t* t, uint64_t first, uint64_t n)
+{
+	uint8_t frame[TRACE_MAX_COLS], prev[TRACE_MAX_COLS], prev2[TRACE_MAX_COLS];
+	uint64_t f, last = first, still = 0, other = 0;
+	uint8_t reseed, cols;
+	trace_info_t info;
+
+	traceInfo(t, &info);
+	cols = info.cols;
+	if (first >= 2) {
+		traceSeek(t, first - 2);
+		traceNext(t, prev2, NULL);
+		traceNext(t, prev, NULL);
+	}
+	else {
+		traceSeek(t, first);
+		memset(prev, 0xFF, cols);
+		memset(prev2, 0, cols);
+	}
+	for (f = first; f < first + n && traceNext(t, frame, &reseed); f++) {
+		if (reseed && f) {
+			int flat = !memcmp(prev, prev2, cols);
+
+			printf("frame %" PRIu64 ": reseed after %s (%" PRIu64 " frames since frame %" PRIu64 ")\n",
+				f, flat ? "a still life" : "the maximum number of generations", f - last, last);
+			if (flat) {
+				still++;
+			}
+			else {
+				other++;
+			}
+			last = f;
+		}
+		memcpy(prev2, prev, cols);
+		memcpy(prev, frame, cols);
+	}
+	printf("%" PRIu64 " reseeds: %" PRIu64 " after a still life, %" PRIu64 " after the maximum number of generations\n",
+		still + other, still, other);
+}
+
+
+/*======================================================================
+	Function:		diff
+	Input:			two traces, first frame, number of frames
+	Output:			1 if the traces differ, else 0
+	Description:	Compare two traces frame by frame (e.g. recorded with
+					different kernels) and show the first frame in which
+					they differ.
+======================================================================*/
+static int diff(trace_t* a, trace_t* b, uint64_t first, uint64_t n)
+{
+	uint8_t fa[TRACE_MAX_COLS], fb[TRACE_MAX_COLS];
+	uint8_t ra, rb;
+	uint64_t f, count = 0, first_diff = 0;
+	trace_info_t ia, ib;
+
+	traceInfo(a, &ia);
+	traceInfo(b, &ib);
+	if (ia.cols != ib.cols || ia.rows != ib.rows || ia.gens != ib.gens) {
+		printf("the traces have different frame sizes\n");
+		return 1;
+	}
+	if (first < ib.frames) {
+		traceSeek(b, first);
+	}
+	for (f = first; f < first + n && traceNext(a, fa, &ra) && traceNext(b, fb, &rb); f++) {
+		if (ra != rb || memcmp(fa, fb, ia.cols)) {
+			if (!count) {
+				first_diff = f;
+				printf("first difference in frame %" PRIu64 "%s:\n", f, (ra != rb) ? " (reseed)" : "");
+				printFrames(fa, fb, &ia);
+			}
+			count++;
+		}
+	}
+	if (ia.frames != ib.frames) {
+		printf("the traces have %" PRIu64 " and %" PRIu64 " frames\n", ia.frames, ib.frames);
+	}
+	if (count) {
+		printf("%" PRIu64 " of %" PRIu64 " frames differ, the first one is frame %" PRIu64 "\n", count, f - first, first_diff);
+	}
+	else {
+		printf("%" PRIu64 " frames equal\n", f - first);
+	}
+	return count || ia.frames != ib.frames;
+}
+
+
+static void usage(void)
+{
+	const kernel_t* k;
+
+	fprintf(stderr, "usage: lifetrace -r trace [-k kernel] [-g generations] [-s seed] [-w columns] [-i keyframe interval]\n");
+	fprintf(stderr, "       lifetrace [-f first frame] [-n frames] [-e] [-d other trace] trace\n");
+	fprintf(stderr, "kernels:");
+	for (k = kernels; k->name; k++) {
+		fprintf(stderr, " %s", k->name);
+	}
+	fprintf(stderr, "\n");
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	const char* out = NULL;
+	const char* other = NULL;
+	const kernel_t* k = kernels;
+	uint64_t gens = 1000000, first = 0, n = 0;
+	uint8_t frame[TRACE_MAX_COLS], reseed;
+	unsigned seed = 1;
+	int cols = DISP_MAX, interval = TRACE_INTERVAL;
+	int show_frames = 0, show_events = 0, ret = 0;
+	trace_info_t info;
+	trace_t* t;
+	uint64_t f;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:k:g:s:w:i:f:n:ed:")) != -1) {
+		switch (opt) {
+			case 'r': out = optarg; break;
+			case 'k':
+				if (!(k = findKernel(optarg))) {
+					usage();
+				}
+				break;
+			case 'g': gens = strtoull(optarg, NULL, 0); break;
+			case 's': seed = atoi(optarg); break;
+			case 'w': cols = atoi(optarg); break;
+			case 'i': interval = atoi(optarg); break;
+			case 'f': first = strtoull(optarg, NULL, 0); show_frames = 1; break;
+			case 'n': n = strtoull(optarg, NULL, 0); show_frames = 1; break;
+			case 'e': show_events = 1; break;
+			case 'd': other = optarg; break;
+			default: usage();
+		}
+	}
+	if (out) {
+		if (optind != argc || cols < 3 || cols > TRACE_MAX_COLS || interval < 1 || gens < 1) {
+			usage();
+		}
+		record(out, k, gens, seed, cols, interval);
+		return 0;
+	}
+	if (optind != argc - 1) {
+		usage();
+	}
+	if (!(t = traceOpen(argv[optind]))) {
+		fail(traceError());
+	}
+	traceInfo(t, &info);
+	if (show_frames && first >= info.frames) {
+		fail("first frame beyond the end of the trace");
+	}
+	if (!n) {
+		n = (show_events || other) ? info.frames - first : 1;
+	}
+
+	if (other) {
+		trace_t* b = traceOpen(other);
+
+		if (!b) {
+			fail(traceError());
+		}
+		traceSeek(t, first);
+		ret = diff(t, b, first, n);
+		traceClose(b);
+	}
+	else if (show_events) {
+		events(t, first, n);
+	}
+	else if (show_frames) {
+		traceSeek(t, first);
+		for (f = first; f < first + n && traceNext(t, frame, &reseed); f++) {
+			printf("frame %" PRIu64 " (generation %" PRIu64 ")%s\n", f, f * info.gens, reseed ? ", reseeded" : "");
+			printFrames(frame, NULL, &info);
+		}
+	}
+	else {
+		summary(argv[optind], t, &info);
+	}
+	traceClose(t);
+	return ret;
+}
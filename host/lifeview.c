@@ -0,0 +1,512 @@
+/*
+ * lifeview.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Live terminal viewer of the firmware loop (generation,
+					still life detection and reseeding of dmScroll) or of a
+					trace recorded by lifetrace. A viewport of the display
+					memory, which pans like display.base, is drawn with ANSI
+					escape sequences: only the cells which changed since the
+					last frame are sent (each one cursor addressed unless it
+					follows the previous one), and every frame is a single
+					write(). The status line shows the generation, the
+					generations and frames per second and the last reseed.
+					Keys: left / right (or h / l) pan, space pauses, n steps
+					while paused, + / - change the generations per frame,
+					r reseeds, q quits.
+Usage:				lifeview [-k kernel] [-s seed] [-w columns] [-l pattern]
+					[-t trace] [-v viewport columns] [-f frames/s]
+					[-g generations per frame] [-n frames] [-a]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "dot_matrix.h"
+#include "life.h"
+#include "kernels.h"
+#include "patio.h"
+#include "trace.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define MAX_COLS		240				// DISP_MAX limit
+#define OUT_SIZE		65536			// output buffer of a frame
+#define STATUS_TIME		0.1				// interval of status line updates [s]
+#define TOP				2				// screen row of the first matrix row
+#define LEFT			3				// screen column of the first matrix column
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	char buf[OUT_SIZE];
+	size_t len;
+	int row, col;						// cursor position on the screen (0 = unknown)
+} screen_t;
+
+
+/********************
+ * global variables *
+ ********************/
+
+static const kernel_t* kernel;
+static kernel_t trace_kernel = {"trace", NULL, 1};	// generations per frame of the trace
+static trace_t* trace;					// replayed trace or NULL
+static uint8_t world[MAX_COLS];
+static uint8_t prev[MAX_COLS];			// generation before world
+static uint8_t cols = DISP_COLUMNS;
+static uint8_t shown[DISP_ROWS][MAX_COLS];	// cells on the screen (2 = unknown)
+static screen_t scr;
+static const char* glyph[2] = {"  ", "\xe2\x96\x88\xe2\x96\x88"};	// dead, alive (two full blocks)
+static struct termios saved;
+static int raw;							// terminal in raw mode
+
+static uint64_t generation, reseeds, last_reseed;
+static const char* last_cause = "";
+
+
+/*************
+ * functions *
+ *************/
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "lifeview: %s\n", msg);
+	exit(1);
+}
+
+
+static void put(const char* s, size_t n)
+{
+	if (scr.len + n > OUT_SIZE) {
+		return;							// cannot happen with MAX_COLS
+	}
+	memcpy(scr.buf + scr.len, s, n);
+	scr.len += n;
+}
+
+
+static void putNum(unsigned n)
+{
+	char digits[10];
+	int i = 0;
+
+	do {
+		digits[i++] = '0' + n % 10;
+		n /= 10;
+	} while (n);
+	while (i) {
+		put(&digits[--i], 1);
+	}
+}
+
+
+static void moveTo(int row, int col)
+{
+	if (row == scr.row && col == scr.col) {
+		return;
+	}
+	put("\x1b[", 2);
+	putNum(row);
+	put(";", 1);
+	putNum(col);
+	put("H", 1);
+	scr.row = row;
+	scr.col = col;
+}
+
+
+static void flush(void)
+{
+	size_t done = 0;
+	ssize_t n;
+
+	while (done < scr.len && (n = write(STDOUT_FILENO, scr.buf + done, scr.len - done)) > 0) {
+		done += n;
+	}
+	scr.len = 0;
+}
+
+
+static void restoreTerminal(void)
+{
+	if (raw) {
+		scr.len = 0;
+		put("\x1b[?25h\x1b[?1049l", 14);	// show the cursor, leave the alternate screen
+		flush();
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+		raw = 0;
+	}
+}
+
+
+static void quit(int sig)
+{
+	(void)sig;
+	restoreTerminal();
+	_exit(0);
+}
+
+
+static void setupTerminal(void)
+{
+	struct termios t;
+
+	if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO) || tcgetattr(STDIN_FILENO, &saved)) {
+		return;							// not interactive (e.g. benchmark with -n)
+	}
+	t = saved;
+	t.c_lflag &= ~(ICANON | ECHO);
+	t.c_cc[VMIN] = 0;
+	t.c_cc[VTIME] = 0;
+	tcsetattr(STDIN_FILENO, TCSAFLUSH, &t);
+	raw = 1;
+	atexit(restoreTerminal);
+	signal(SIGINT, quit);
+	signal(SIGTERM, quit);
+	put("\x1b[?1049h\x1b[?25l\x1b[2J", 18);	// alternate screen, hide the cursor, clear
+	flush();
+}
+
+
+// new world like dmWakeUp()
+static void seedWorld(void)
+{
+	uint8_t x;
+
+	for (x = 0; x < cols; x++) {
+		world[x] = rand() % (1 << DISP_ROWS);
+	}
+}
+
+
+static void noteReseed(const char* cause)
+{
+	reseeds++;
+	last_reseed = generation;
+	last_cause = cause;
+}
+
+
+/*======================================================================
+	Function:		advance
+	Input:			none
+	Output:			0 at the end of a trace, else 1
+	Description:	Compute the next generation like dmScroll (or read the
+					next frame of the trace) and note reseeds with their
+					cause: a still life or the maximum number of generations.
+======================================================================*/
+static int advance(void)
+{
+	uint8_t next[MAX_COLS];
+	uint8_t still, reseed;
+
+	if (trace) {
+		if (!traceNext(trace, next, &reseed)) {
+			return 0;
+		}
+		still = !memcmp(world, prev, cols);
+		memcpy(prev, world, cols);
+		memcpy(world, next, cols);
+		generation += kernel->gens;
+		if (reseed) {
+			noteReseed(still ? "still life" : "max. generations");
+		}
+		return 1;
+	}
+	kernel->step(next, world, cols);
+	still = !memcmp(next, world, cols);
+	memcpy(prev, world, cols);
+	memcpy(world, next, cols);
+	generation += kernel->gens;
+	if (lifeReseedDue(still)) {
+		seedWorld();
+		noteReseed(still ? "still life" : "max. generations");
+	}
+	return 1;
+}
+
+
+/*======================================================================
+	Function:		render
+	Input:			first displayed column (like display.base), viewport
+					columns
+	Output:			none
+	Description:	Append the cells which differ from the screen to the
+					output buffer. Consecutive changed cells of a row share
+					one cursor movement.
+======================================================================*/
+static void render(uint8_t base, uint8_t view)
+{
+	uint8_t v, x, y, alive;
+	size_t n = strlen(glyph[1]);
+
+	for (y = 0; y < DISP_ROWS; y++) {
+		for (v = 0; v < view; v++) {
+			x = (base + v) % cols;
+			alive = (world[x] >> y) & 1;
+			if (alive == shown[y][v]) {
+				continue;
+			}
+			moveTo(TOP + y, LEFT + 2 * v);
+			put(glyph[alive], alive ? n : strlen(glyph[0]));
+			scr.col += 2;
+			shown[y][v] = alive;
+		}
+	}
+}
+
+
+static void drawFrame(uint8_t view)
+{
+	uint8_t v, y;
+
+	scr.len = 0;
+	scr.row = scr.col = 0;
+	put("\x1b[2J", 4);
+	for (y = 0; y <= DISP_ROWS + 1; y++) {
+		moveTo(TOP - 1 + y, LEFT - 1);
+		put((y == 0 || y == DISP_ROWS + 1) ? "+" : "|", 1);
+		for (v = 0; v < view; v++) {
+			put((y == 0 || y == DISP_ROWS + 1) ? "--" : "  ", 2);
+		}
+		put((y == 0 || y == DISP_ROWS + 1) ? "+" : "|", 1);
+		scr.col += 2 * view + 2;
+	}
+	memset(shown, 2, sizeof(shown));
+}
+
+
+static void status(uint8_t base, uint8_t view, unsigned per_frame, double gens_s, double fps, int paused)
+{
+	char line[256];
+	int n;
+
+	n = snprintf(line, sizeof(line),
+		"gen %" PRIu64 "  %.0f gens/s  %.0f frames/s  %u gens/frame  columns %u-%u of %u%s\x1b[K",
+		generation, gens_s, fps, per_frame, base, (base + view - 1) % cols, cols, paused ? "  PAUSED" : "");
+	moveTo(TOP + DISP_ROWS + 2, 1);
+	put(line, n);
+	n = snprintf(line, sizeof(line), "reseeds %" PRIu64, reseeds);
+	if (reseeds) {
+		n += snprintf(line + n, sizeof(line) - n, ", last at gen %" PRIu64 " (%s)", last_reseed, last_cause);
+	}
+	n += snprintf(line + n, sizeof(line) - n, "\x1b[K");
+	moveTo(TOP + DISP_ROWS + 3, 1);
+	put(line, n);
+	scr.row = scr.col = 0;				// the cursor position after the text is not tracked
+}
+
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: lifeview [-k kernel] [-s seed] [-w columns] [-l pattern] [-t trace] [-v viewport columns]\n");
+	fprintf(stderr, "                [-f frames/s] [-g generations per frame] [-n frames] [-a]\n");
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	const char* pattern = NULL;
+	const char* trace_file = NULL;
+	unsigned seed = 1, per_frame = 1;
+	int view = DISP_COLUMNS, fps = 200, width = DISP_MAX;
+	long frames = 0, frame = 0;
+	uint8_t base = 0;
+	int paused = 0, step = 0, running = 1;
+	uint64_t bytes = 0, status_gen = 0;
+	long status_frames = 0;
+	double start, status_time, next, t;
+	double gens_s = 0, frames_s = 0;
+	size_t full = 0;
+	int opt;
+
+	kernel = kernels;
+	while ((opt = getopt(argc, argv, "k:s:w:l:t:v:f:g:n:a")) != -1) {
+		switch (opt) {
+			case 'k':
+				if (!(kernel = findKernel(optarg))) {
+					usage();
+				}
+				break;
+			case 's': seed = atoi(optarg); break;
+			case 'w': width = atoi(optarg); break;
+			case 'l': pattern = optarg; break;
+			case 't': trace_file = optarg; break;
+			case 'v': view = atoi(optarg); break;
+			case 'f': fps = atoi(optarg); break;
+			case 'g': per_frame = atoi(optarg); break;
+			case 'n': frames = atol(optarg); break;
+			case 'a': glyph[0] = ". "; glyph[1] = "O "; break;
+			default: usage();
+		}
+	}
+	if (optind != argc || width < 3 || width > MAX_COLS || fps < 0 || per_frame < 1) {
+		usage();
+	}
+	cols = width;
+
+	srand(seed);
+	lifeResetCounters();
+	if (trace_file) {
+		trace_info_t info;
+
+		if (!(trace = traceOpen(trace_file))) {
+			fail(traceError());
+		}
+		traceInfo(trace, &info);
+		if (info.rows != DISP_ROWS) {
+			fail("the trace has a different number of rows");
+		}
+		cols = info.cols;
+		if (!traceNext(trace, world, NULL)) {
+			fail("empty trace");
+		}
+		trace_kernel.gens = info.gens;
+		kernel = &trace_kernel;
+	}
+	else if (pattern) {
+		pat_target_t target = patTargetCols(world, cols, DISP_ROWS);
+		pat_info_t info;
+
+		if (patLoad(pattern, &target, &info)) {
+			fail(patError());
+		}
+	}
+	else {
+		seedWorld();
+	}
+	memcpy(prev, world, cols);
+	if (view < 1 || view > cols) {
+		view = cols;
+	}
+	full = DISP_ROWS * (strlen("\x1b[") + 5 + view * strlen(glyph[1]));	// one cursor movement per row
+
+	setupTerminal();
+	drawFrame(view);
+	start = status_time = next = now();
+	while (running && (!frames || frame < frames)) {
+		unsigned g;
+
+		if (!paused || step) {
+			for (g = 0; g < per_frame; g++) {
+				if (!advance()) {
+					paused = 1;			// end of the trace
+					running = raw;
+					break;
+				}
+			}
+			step = 0;
+		}
+		render(base, view);
+		frame++;
+		t = now();
+		if (t - status_time >= STATUS_TIME) {
+			gens_s = (generation - status_gen) / (t - status_time);
+			frames_s = (frame - status_frames) / (t - status_time);
+			status_gen = generation;
+			status_frames = frame;
+			status_time = t;
+			status(base, view, per_frame, gens_s, frames_s, paused);
+		}
+		bytes += scr.len;
+		flush();
+
+		// keys, wait for the next frame
+		next += fps ? 1.0 / fps : 0;
+		do {
+			struct pollfd p = {STDIN_FILENO, POLLIN, 0};
+			int timeout = (next > now()) ? (int)((next - now()) * 1000) : 0;
+			char keys[16];
+			int i, n;
+
+			if (!raw) {
+				break;
+			}
+			if (poll(&p, 1, paused ? 100 : timeout) <= 0) {
+				continue;
+			}
+			n = read(STDIN_FILENO, keys, sizeof(keys));
+			for (i = 0; i < n; i++) {
+				switch (keys[i]) {
+					case 'q': running = 0; break;
+					case ' ': paused = !paused; break;
+					case 'n': step = 1; break;
+					case '+': per_frame *= 2; break;
+					case '-': if (per_frame > 1) per_frame /= 2; break;
+					case 'r':
+						if (!trace) {
+							seedWorld();
+							lifeResetCounters();
+							noteReseed("key");
+						}
+						break;
+					case 'h':
+					case 'D':			// cursor left (ESC [ D)
+						base = base ? base - 1 : cols - 1;
+						break;
+					case 'l':
+					case 'C':			// cursor right (ESC [ C)
+						base = (base + 1) % cols;
+						break;
+				}
+			}
+			status(base, view, per_frame, gens_s, frames_s, paused);
+			render(base, view);
+			flush();
+			if (step || !running) {
+				break;
+			}
+		} while (now() < next || (paused && running && !step));
+		if (fps && now() > next + 0.1) {
+			next = now();				// do not try to catch up after a stall
+		}
+	}
+	restoreTerminal();
+	t = now() - start;
+	fprintf(stderr, "%ld frames, %" PRIu64 " generations in %.2f s: %.0f frames/s, %.0f generations/s\n",
+		frame, generation, t, frame / t, generation / t);
+	fprintf(stderr, "%.1f bytes per frame (a full redraw takes about %zu bytes)\n", (double)bytes / frame, full);
+	return 0;
+}
@@ -0,0 +1,238 @@
+/*
+ * linksim.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Host side loopback simulation of the daisy chain (link.c).
+					Several boards are connected through byte queues that stand in
+					for the USART lines. Every board computes its part of the shared
+					world which is compared against a single wide reference world.
+					The lines can lose bytes (lost bytes per 1000), the master
+					then has to restart the exchange and reseed. Random button
+					presses ask for new worlds; all boards have to seed their
+					parts at the same generation.
+Usage:				linksim [generations] [random seed] [lost bytes per 1000]
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+#include "dot_matrix.h"
+#include "life.h"
+#include "link.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define WORLD_COLS		(LINK_NODES * DISP_COLUMNS)
+#define LINE_SIZE		256				// capacity of one simulated USART line
+#define PRESS_RATE		97				// one button press every PRESS_RATE calls of linkStart() on average
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	uint8_t data[LINE_SIZE];
+	uint16_t head, tail;
+} line_t;
+
+typedef struct {
+	link_t link;						// must be the first member (see linePut)
+	uint8_t world[DISP_COLUMNS + 2];
+	line_t* tx;							// line to the next board
+	uint8_t seeded;						// 1 = has seeded a new part during the current exchange
+} board_t;
+
+
+/********************
+ * global variables *
+ ********************/
+
+board_t boards[LINK_NODES];
+line_t lines[LINK_NODES];				// line i connects board i to board i + 1
+unsigned loss;							// lost bytes per 1000
+unsigned long lost;
+
+
+/*************
+ * functions *
+ *************/
+
+static void linePut(link_t* l, uint8_t byte)
+{
+	line_t* line = ((board_t*)l)->tx;
+
+	line->data[line->head] = byte;
+	line->head = (line->head + 1) % LINE_SIZE;
+	if (line->head == line->tail) {
+		fprintf(stderr, "line overflow\n");
+		exit(2);
+	}
+}
+
+
+static void soup(board_t* b)
+{
+	uint8_t x;
+
+	for (x = 0; x < DISP_COLUMNS; x++) {
+		b->world[1 + x] = rand() % 0x80;
+	}
+}
+
+
+/*======================================================================
+	Function:		pump
+	Input:			none
+	Output:			number of bytes delivered
+	Description:	Deliver the pending bytes of the lines in random order,
+					one byte per randomly chosen line at a time, so that the
+					boards see arbitrary interleavings. A byte is lost with
+					a probability of loss / 1000.
+======================================================================*/
+static unsigned pump(void)
+{
+	unsigned delivered = 0;
+	uint8_t i, busy;
+
+	do {
+		busy = 0;
+		for (i = 0; i < LINK_NODES; i++) {
+			line_t* line = &lines[(i + rand()) % LINK_NODES];
+			uint8_t to = (line - lines + 1) % LINK_NODES;
+
+			if (line->head != line->tail && (rand() & 1)) {
+				uint8_t byte = line->data[line->tail];
+				line->tail = (line->tail + 1) % LINE_SIZE;
+				if ((unsigned)(rand() % 1000) < loss) {
+					lost++;
+					continue;
+				}
+				linkReceive(&boards[to].link, byte);
+				delivered++;
+			}
+		}
+		for (i = 0; i < LINK_NODES; i++) {
+			busy |= (lines[i].head != lines[i].tail);
+		}
+	} while (busy);
+	return delivered;
+}
+
+
+int main(int argc, char** argv)
+{
+	unsigned long generations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000;
+	unsigned seed = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+	uint8_t ref[WORLD_COLS], next[WORLD_COLS];
+	uint8_t tmp[DISP_COLUMNS + 2];
+	unsigned long gen = 0, calls = 0, bytes = 0, reseeds = 0, presses = 0;
+	uint8_t i, x, done;
+
+	loss = (argc > 3) ? strtoul(argv[3], NULL, 0) : 0;
+	srand(seed);
+	for (i = 0; i < LINK_NODES; i++) {
+		linkReset(&boards[i].link, boards[i].world, i);
+		boards[i].link.put = linePut;
+		boards[i].tx = &lines[i];
+		soup(&boards[i]);
+	}
+	for (x = 0; x < WORLD_COLS; x++) {
+		ref[x] = boards[x / DISP_COLUMNS].world[1 + x % DISP_COLUMNS];
+	}
+
+	while (gen < generations) {
+		if (++calls > 100 * generations + 1000) {
+			printf("generation %lu: the ring has stalled\n", gen);
+			return 1;
+		}
+		if (rand() % PRESS_RATE == 0) {	// button of a random board
+			linkRequestReseed(&boards[rand() % LINK_NODES].link);
+			presses++;
+		}
+
+		linkStart(&boards[0].link);		// system timer of the master
+		bytes += pump();
+
+		done = boards[0].link.ready;	// the exchange has completed
+		for (i = 0; i < LINK_NODES; i++) {	// main() of every board
+			link_t* l = &boards[i].link;
+
+			if (!loss && (!l->ready || l->errors)) {
+				printf("generation %lu: board %u not ready (errors = %u)\n", gen, i, l->errors);
+				return 1;
+			}
+			boards[i].seeded = 0;
+			if (!l->ready) {
+				continue;
+			}
+			if (l->reseed) {
+				soup(&boards[i]);
+				boards[i].seeded = 1;
+				l->changed = 1;
+			}
+			else {
+				lifeStepRef(tmp, boards[i].world, DISP_COLUMNS + 2);
+				l->changed = (memcmp(tmp + 1, boards[i].world + 1, DISP_COLUMNS) != 0);
+				memcpy(boards[i].world, tmp, sizeof(tmp));
+			}
+			l->ready = 0;
+		}
+		if (!done) {
+			continue;					// lost byte: the master restarts the exchange
+		}
+
+		if (boards[0].link.reseed) {	// all boards have to seed at the same generation
+			for (i = 0; i < LINK_NODES; i++) {
+				if (!boards[i].seeded) {
+					printf("generation %lu: board %u has not seeded the new world\n", gen, i);
+					return 1;
+				}
+			}
+			for (x = 0; x < WORLD_COLS; x++) {
+				ref[x] = boards[x / DISP_COLUMNS].world[1 + x % DISP_COLUMNS];
+			}
+			reseeds++;
+		}
+		else {
+			lifeStepRef(next, ref, WORLD_COLS);
+			memcpy(ref, next, sizeof(ref));
+			for (x = 0; x < WORLD_COLS; x++) {
+				if (boards[x / DISP_COLUMNS].world[1 + x % DISP_COLUMNS] != ref[x]) {
+					printf("generation %lu: column %u differs from the reference\n", gen, x);
+					return 1;
+				}
+			}
+		}
+		gen++;
+	}
+
+	printf("%u boards, %lu generations: ok (%.1f bytes per board and generation, %lu reseeds, %lu presses, "
+		"%lu bytes lost, %.2f linkStart() calls per generation)\n", LINK_NODES, generations,
+		(double)bytes / generations / LINK_NODES, reseeds, presses, lost, (double)calls / generations);
+	return 0;
+}
@@ -0,0 +1,313 @@
+/*
+ * patenc.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Pattern library encoder. Reads Life patterns in the RLE
+					(.rle), plaintext (.cells) or macrocell (.mc) format
+					(see patio.h) and prints them as patterns.h, the compressed pattern library
+					of the firmware (see PATTERN_LIBRARY in config.h and
+					dmDecodePattern() in dot_matrix.c).
+					Every pattern is trimmed to its live cells and turned by 90
+					degrees if it is higher than the display but fits in its
+					width. Format of a pattern:
+						1 byte (width - 1) << 3 | (height - 1), up to 32 x 8
+						per column, bit stream starting at bit 0:
+							0 + height bits		column (bit 0 = top row)
+							1 0					empty column
+							1 1					same as the previous column
+						padded to a full byte
+					The decoder centres the pattern vertically.
+Usage:				patenc [-w max width] pattern files > patterns.h
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "dot_matrix.h"
+#include "torus.h"
+#include "patio.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define MAX_COLS		DISP_PATTERN_COLS	// width limit of the format (5 bits of the header)
+#define MAX_SIZE		256				// input patterns (before trimming)
+#define MAX_PATTERNS	255
+#define MAX_BYTES		(1 + (MAX_COLS * (1 + DISP_ROWS) + 7) / 8)
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	uint8_t* data;
+	int pos;							// bit position
+} bitwriter_t;
+
+
+/********************
+ * global variables *
+ ********************/
+
+static torus_t* world;					// MAX_SIZE x MAX_SIZE, holds one pattern at a time
+static char name[PAT_NAME];
+
+
+/*************
+ * functions *
+ *************/
+
+static void fail(const char* file, const char* msg)
+{
+	fprintf(stderr, "patenc: %s: %s\n", file, msg);
+	exit(1);
+}
+
+
+/*======================================================================
+	Function:		readPattern
+	Input:			file name, columns (output), height (output)
+	Output:			number of columns
+	Description:	Read a pattern file (RLE, plaintext or macrocell, see
+					patio.h) and convert the bounding box of its live cells
+					into columns (bit 0 = top row).
+======================================================================*/
+static int readPattern(const char* file, uint8_t* cols, int* height)
+{
+	const char* base = strrchr(file, '/');
+	pat_target_t t = patTargetTorus(world);
+	pat_info_t info;
+	int x0 = MAX_SIZE, y0 = MAX_SIZE, x1 = -1, y1 = -1;
+	int x, y, w, h, turn;
+	char msg[64];
+
+	if (patLoad(file, NULL, &info)) {
+		fail(file, patError());
+	}
+	if (info.width > MAX_SIZE || info.height > MAX_SIZE) {
+		fail(file, "pattern too large");
+	}
+	torusClear(world);
+	if (patLoad(file, &t, &info)) {
+		fail(file, patError());
+	}
+	if (info.name[0]) {
+		strcpy(name, info.name);
+	}
+	else {
+		snprintf(name, sizeof(name), "%s", base ? base + 1 : file);
+		if (strchr(name, '.')) {
+			*strchr(name, '.') = 0;
+		}
+	}
+
+	for (y = 0; y < (int)info.height; y++) {
+		for (x = 0; x < (int)info.width; x++) {
+			if (torusGetCell(world, x, y)) {
+				if (x < x0) x0 = x;
+				if (x > x1) x1 = x;
+				if (y < y0) y0 = y;
+				if (y > y1) y1 = y;
+			}
+		}
+	}
+	if (x1 < 0) {
+		fail(file, "no live cells");
+	}
+	w = x1 - x0 + 1;
+	h = y1 - y0 + 1;
+	turn = (h > DISP_ROWS) && (w <= DISP_ROWS);
+	if (turn) {
+		x = w;
+		w = h;
+		h = x;
+	}
+	if (h > DISP_ROWS) {
+		fail(file, "higher than the display");
+	}
+	if (w > MAX_COLS) {
+		snprintf(msg, sizeof(msg), "%d columns, the pattern library holds at most %d", w, MAX_COLS);
+		fail(file, msg);
+	}
+	for (x = 0; x < w; x++) {
+		cols[x] = 0;
+		for (y = 0; y < h; y++) {
+			if (turn ? torusGetCell(world, x0 + y, y0 + x) : torusGetCell(world, x0 + x, y0 + y)) {
+				cols[x] |= 1 << y;
+			}
+		}
+	}
+	*height = h;
+	return w;
+}
+
+
+static void putBits(bitwriter_t* b, uint8_t value, uint8_t n)
+{
+	while (n--) {
+		if (value & 1) {
+			b->data[b->pos / 8] |= 1 << (b->pos % 8);
+		}
+		value >>= 1;
+		b->pos++;
+	}
+}
+
+
+/*======================================================================
+	Function:		encode
+	Input:			columns, width, height, output buffer
+	Output:			number of bytes
+	Description:	Encode a pattern in the format of the pattern library.
+======================================================================*/
+static int encode(const uint8_t* cols, int width, int height, uint8_t* out)
+{
+	bitwriter_t b = {out + 1, 0};
+	int x;
+
+	memset(out, 0, MAX_BYTES);
+	out[0] = (width - 1) << 3 | (height - 1);
+	for (x = 0; x < width; x++) {
+		if (x > 0 && cols[x] == cols[x - 1] && cols[x]) {
+			putBits(&b, 3, 2);
+		}
+		else if (cols[x] == 0) {
+			putBits(&b, 1, 2);
+		}
+		else {
+			putBits(&b, 0, 1);
+			putBits(&b, cols[x], height);
+		}
+	}
+	return 1 + (b.pos + 7) / 8;
+}
+
+
+static uint8_t getBit(const uint8_t* data, int* pos)
+{
+	uint8_t bit = (data[*pos / 8] >> (*pos % 8)) & 1;
+
+	(*pos)++;
+	return bit;
+}
+
+
+/*======================================================================
+	Function:		decode
+	Input:			encoded pattern, columns (output)
+	Output:			number of bytes
+	Description:	Same algorithm as dmDecodePattern() without the
+					vertical centring, used to check the encoder.
+======================================================================*/
+static int decode(const uint8_t* in, uint8_t* cols)
+{
+	int width = (in[0] >> 3) + 1, height = (in[0] & 7) + 1;
+	int pos = 0, x, i;
+	uint8_t col = 0;
+
+	#define BIT()	getBit(in + 1, &pos)
+	for (x = 0; x < width; x++) {
+		if (!BIT()) {
+			col = 0;
+			for (i = 0; i < height; i++) {
+				col |= BIT() << i;
+			}
+		}
+		else if (!BIT()) {
+			col = 0;
+		}
+		cols[x] = col;
+	}
+	#undef BIT
+	return 1 + (pos + 7) / 8;
+}
+
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: patenc [-w max width] pattern files (.rle, .cells, .mc) > patterns.h\n");
+	exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+	uint8_t cols[MAX_COLS], check[MAX_COLS], out[MAX_BYTES];
+	static char lines[MAX_PATTERNS][5 * MAX_BYTES + PAT_NAME + 32];
+	int max_width = MAX_COLS;
+	int count = 0, total = 0, raw = 0;
+	int i, w, h, n, len, opt;
+
+	while ((opt = getopt(argc, argv, "w:")) != -1) {
+		switch (opt) {
+			case 'w': max_width = atoi(optarg); break;
+			default: usage();
+		}
+	}
+	if (optind >= argc || max_width < 1 || max_width > MAX_COLS) {
+		usage();
+	}
+	if (!(world = torusCreate(MAX_SIZE, MAX_SIZE, 1))) {
+		fail("torus", "out of memory");
+	}
+
+	for (; optind < argc; optind++) {
+		w = readPattern(argv[optind], cols, &h);
+		if (w > max_width) {
+			fprintf(stderr, "patenc: %s: skipped, %d columns\n", argv[optind], w);
+			continue;
+		}
+		if (count == MAX_PATTERNS) {
+			fail(argv[optind], "too many patterns");
+		}
+		n = encode(cols, w, h, out);
+		if (decode(out, check) != n || memcmp(cols, check, w)) {
+			fail(argv[optind], "encoder check failed");
+		}
+		len = 0;
+		for (i = 0; i < n; i++) {
+			len += sprintf(lines[count] + len, "0x%02x,", out[i]);
+		}
+		sprintf(lines[count] + len, "%*s// %s, %dx%d", (len < 50) ? 50 - len : 1, "", name, w, h);
+		count++;
+		total += n;
+		raw += w;
+	}
+
+	printf("// generated by patenc: compressed pattern library (see PATTERN_LIBRARY in config.h)\n");
+	printf("// per pattern: (width - 1) << 3 | (height - 1), then a bit stream (from bit 0)\n");
+	printf("// with 0 + height bits = column, 10 = empty column, 11 = previous column\n");
+	printf("#define PATTERN_ROWS\t%d\n", DISP_ROWS);
+	printf("#define PATTERN_COUNT\t%d\n\n", count);
+	printf("const uint8_t patterns[] PROGMEM = {\n");
+	for (i = 0; i < count; i++) {
+		printf("\t%s\n", lines[i]);
+	}
+	printf("};\n");
+	fprintf(stderr, "%d patterns, %d bytes (%d bytes as plain columns)\n", count, total, raw);
+	return 0;
+}
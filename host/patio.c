@@ -0,0 +1,1147 @@
+/*
+ * patio.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Pattern import and export for the host tools (see patio.h).
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "patio.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define RLE_LINE		70				// maximum line length of RLE output
+#define MC_LEAF			3				// level of the macrocell leaves (8 x 8 cells)
+#define MC_MAX_LEVEL	63
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	uint64_t* tile;						// torus: tile of the last write, NULL = none yet
+	uint32_t tx, ty;
+} tile_cache_t;
+
+
+typedef struct {
+	uint32_t x, y, width, height;
+} box_t;
+
+typedef struct {
+	uint8_t level;
+	uint8_t empty;
+	uint32_t child[4];					// nw, ne, sw, se (0 = empty), level > MC_LEAF
+	uint64_t leaf;						// byte c = column c (bit r = row r), level MC_LEAF
+	uint64_t x0, y0, x1, y1;			// bounding box of the live cells within the node
+} mc_node_t;
+
+typedef struct {
+	mc_node_t* node;					// node[0] = empty node
+	uint32_t count, size;
+	uint64_t x0, y0;					// import: bounding box of the root
+	tile_cache_t cache;
+	box_t box;							// export: bounding box of the world
+	uint32_t* hash;						// export: open addressing, 0 = free slot
+	uint32_t hash_size;
+	FILE* f;
+} mc_tree_t;
+
+
+/********************
+ * global variables *
+ ********************/
+
+static char error[256];
+
+
+/*************
+ * functions *
+ *************/
+
+static int fail(const char* fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(error, sizeof(error), fmt, ap);
+	va_end(ap);
+	return -1;
+}
+
+
+const char* patError(void)
+{
+	return error;
+}
+
+
+pat_target_t patTargetCols(uint8_t* cols, uint32_t width, uint32_t height)
+{
+	pat_target_t t = {cols, NULL, width, height, 0, 0};
+
+	return t;
+}
+
+
+pat_target_t patTargetTorus(torus_t* torus)
+{
+	pat_target_t t = {NULL, torus, torusWidth(torus), torusHeight(torus), 0, 0};
+
+	return t;
+}
+
+
+/*======================================================================
+	Function:		patFormat
+	Input:			file name
+	Output:			format (PAT_...), -1 if the extension is unknown
+	Description:	Format of a file from its extension.
+======================================================================*/
+int patFormat(const char* file)
+{
+	const char* ext = strrchr(file, '.');
+
+	if (!ext || strchr(ext, '/')) {
+		return -1;
+	}
+	if (!strcmp(ext, ".rle")) {
+		return PAT_RLE;
+	}
+	if (!strcmp(ext, ".cells") || !strcmp(ext, ".txt")) {
+		return PAT_PLAINTEXT;
+	}
+	if (!strcmp(ext, ".mc")) {
+		return PAT_MACROCELL;
+	}
+	return -1;
+}
+
+
+// columns of a torus tile which is about to be written, touched once per tile change
+static inline uint64_t* writeTile(const pat_target_t* t, tile_cache_t* c, uint32_t tx, uint32_t ty)
+{
+	if (!c->tile || c->tx != tx || c->ty != ty) {
+		c->tile = torusTile(t->torus, tx, ty);
+		c->tx = tx;
+		c->ty = ty;
+		torusTouch(t->torus, tx, ty);
+	}
+	return c->tile;
+}
+
+
+/*======================================================================
+	Function:		putRun
+	Input:			target, tile cache, position, number of cells
+	Output:			none
+	Description:	Set a horizontal run of live cells. In a torus the run
+					is or-ed into the columns of one tile after the other.
+======================================================================*/
+static inline void putRun(const pat_target_t* t, tile_cache_t* cache, uint32_t x, uint32_t y, uint64_t n)
+{
+	if (!t) {
+		return;
+	}
+	if (t->cols) {
+		uint8_t bit = 1 << y;
+
+		while (n--) {
+			t->cols[x] |= bit;
+			if (++x == t->width) {
+				x = 0;
+			}
+		}
+		return;
+	}
+	while (n) {
+		uint32_t c = x % TORUS_TILE;
+		uint32_t k = (n < TORUS_TILE - c) ? n : TORUS_TILE - c;
+		uint64_t* col = writeTile(t, cache, x / TORUS_TILE, y / TORUS_TILE) + c;
+		uint64_t bit = (uint64_t)1 << (y % TORUS_TILE);
+		uint32_t i;
+
+		for (i = 0; i < k; i++) {
+			col[i] |= bit;
+		}
+		n -= k;
+		x += k;
+		if (x == t->width) {
+			x = 0;						// the width is a multiple of the tile size
+		}
+	}
+}
+
+
+/*======================================================================
+	Function:		putBits
+	Input:			target, tile cache, position, bits (bit i = row y + i)
+	Output:			none
+	Description:	Set live cells of a column segment of up to 64 rows.
+======================================================================*/
+static void putBits(const pat_target_t* t, tile_cache_t* cache, uint32_t x, uint32_t y, uint64_t bits)
+{
+	if (!t) {
+		return;
+	}
+	if (t->cols) {
+		for (; bits; bits >>= 1) {
+			if (bits & 1) {
+				t->cols[x] |= 1 << y;
+			}
+			if (++y == t->height) {
+				y = 0;
+			}
+		}
+		return;
+	}
+	while (bits) {
+		uint32_t r = y % TORUS_TILE;
+
+		writeTile(t, cache, x / TORUS_TILE, y / TORUS_TILE)[x % TORUS_TILE] |= bits << r;
+		bits = r ? bits >> (TORUS_TILE - r) : 0;
+		y += TORUS_TILE - r;
+		if (y == t->height) {
+			y = 0;
+		}
+	}
+}
+
+
+/*======================================================================
+	Function:		getBits
+	Input:			target, position, number of rows (<= 64)
+	Output:			bits (bit i = row y + i, rows beyond the world are dead)
+	Description:	Read a column segment for the export.
+======================================================================*/
+static uint64_t getBits(const pat_target_t* t, uint32_t x, uint32_t y, uint32_t n)
+{
+	uint64_t bits = 0;
+	uint32_t i;
+
+	if (x >= t->width || y >= t->height) {
+		return 0;
+	}
+	if (n > t->height - y) {
+		n = t->height - y;
+	}
+	if (t->cols) {
+		for (i = 0; i < n; i++) {
+			bits |= (uint64_t)((t->cols[x] >> (y + i)) & 1) << i;
+		}
+		return bits;
+	}
+	for (i = 0; i < n; ) {
+		uint32_t r = (y + i) % TORUS_TILE;
+		uint64_t col = *(torusTile(t->torus, x / TORUS_TILE, (y + i) / TORUS_TILE) + x % TORUS_TILE);
+
+		bits |= (col >> r) << i;
+		i += TORUS_TILE - r;
+	}
+	return (n < 64) ? bits & (((uint64_t)1 << n) - 1) : bits;
+}
+
+
+// row y of the world, one byte per cell (1 = alive)
+static void getRow(const pat_target_t* t, uint32_t y, uint8_t* row)
+{
+	uint32_t x, i;
+
+	if (t->cols) {
+		for (x = 0; x < t->width; x++) {
+			row[x] = (t->cols[x] >> y) & 1;
+		}
+		return;
+	}
+	for (x = 0; x < t->width; x += TORUS_TILE) {
+		const uint64_t* tile = torusTile(t->torus, x / TORUS_TILE, y / TORUS_TILE);
+
+		for (i = 0; i < TORUS_TILE; i++) {
+			row[x + i] = (tile[i] >> (y % TORUS_TILE)) & 1;
+		}
+	}
+}
+
+
+static void copyLine(char* dst, size_t size, const char* p, const char* end)
+{
+	size_t n = 0;
+
+	while (p < end && (*p == ' ' || *p == '\t')) {
+		p++;
+	}
+	while (p + n < end && p[n] != '\n' && p[n] != '\r' && n < size - 1) {
+		n++;
+	}
+	memcpy(dst, p, n);
+	dst[n] = 0;
+}
+
+
+static const char* nextLine(const char* p, const char* end)
+{
+	const char* nl = memchr(p, '\n', end - p);
+
+	return nl ? nl + 1 : end;
+}
+
+
+/*======================================================================
+	Function:		parseRle
+	Input:			file contents, target (NULL = size only), info
+	Output:			0 or -1
+	Description:	Single pass over the RLE format: comment lines (#N =
+					name), the header line "x = .., y = .., rule = .." and
+					runs of b (dead), o (alive) and $ (end of row) up to !.
+					Dead runs only advance the position.
+======================================================================*/
+static int parseRle(const char* p, const char* end, const pat_target_t* t, pat_info_t* info)
+{
+	uint32_t x0 = t ? t->x : 0, x = x0, y = t ? t->y : 0;
+	uint32_t w = t ? t->width : 1, h = t ? t->height : 1;
+	uint64_t px = 0, py = 0, run = 0, n;
+	uint64_t max_x = 0, max_y = 0, hx = 0, hy = 0;
+	tile_cache_t cache = {NULL, 0, 0};
+
+	// comments and header
+	while (p < end) {
+		if (*p == '#') {
+			if (p + 1 < end && p[1] == 'N') {
+				copyLine(info->name, PAT_NAME, p + 2, end);
+			}
+			else if (p + 1 < end && (p[1] == 'r' || p[1] == 'R')) {
+				copyLine(info->rule, PAT_RULE, p + 2, end);
+			}
+			p = nextLine(p, end);
+		}
+		else if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+			p++;
+		}
+		else if (*p == 'x') {
+			const char* eol = nextLine(p, end);
+			const char* r;
+			char line[256];
+
+			copyLine(line, sizeof(line), p, eol);
+			sscanf(line, "x = %" SCNu64 ", y = %" SCNu64, &hx, &hy);
+			if ((r = strstr(line, "rule"))) {
+				r = strchr(r, '=');
+				copyLine(info->rule, PAT_RULE, r ? r + 1 : r, line + strlen(line));
+			}
+			p = eol;
+			break;
+		}
+		else {
+			break;
+		}
+	}
+
+	// body
+	for (; p < end; p++) {
+		char c = *p;
+
+		if (c >= '0' && c <= '9') {
+			run = run * 10 + (c - '0');
+			continue;
+		}
+		n = run ? run : 1;
+		switch (c) {
+			case 'o':
+				putRun(t, &cache, x, y, n);
+				info->cells += n;
+				px += n;
+				if (px > max_x) max_x = px;
+				if (py + 1 > max_y) max_y = py + 1;
+				x += n;
+				if (x >= w) x %= w;
+				break;
+			case 'b':
+			case '.':
+				px += n;
+				x += n;
+				if (x >= w) x %= w;
+				break;
+			case '$':
+				py += n;
+				px = 0;
+				x = x0;
+				y = (y + n) % h;
+				break;
+			case '!':
+				info->width = (hx > max_x) ? hx : max_x;
+				info->height = (hy > max_y) ? hy : max_y;
+				return 0;
+			case ' ':
+			case '\t':
+			case '\r':
+			case '\n':
+				continue;				// a count never spans white space, but keep it
+			default:
+				return fail("unsupported cell state '%c' in RLE data", c);
+		}
+		run = 0;
+	}
+	return fail("RLE data without the final !");
+}
+
+
+#define BYTES(c)		(0x0101010101010101ull * (uint8_t)(c))
+
+// high bit of every byte of v that is zero
+static inline uint64_t zeroBytes(uint64_t v)
+{
+	return ~(((v & BYTES(0x7F)) + BYTES(0x7F)) | v | BYTES(0x7F));
+}
+
+
+// 8 cells of a plaintext row at once: bit i = cell i alive, -1 = other characters
+static inline int cells8(const char* p)
+{
+	uint64_t v, alive, dead;
+
+	memcpy(&v, p, 8);
+	alive = zeroBytes(v ^ BYTES('O')) | zeroBytes(v ^ BYTES('*'));
+	dead = zeroBytes(v ^ BYTES('.'));
+	if ((alive | dead) != BYTES(0x80)) {
+		return -1;
+	}
+	return ((alive >> 7) * 0x0102040810204080ull) >> 56;	// gather the bits
+}
+
+
+// set the cells of a mask (bit i = cell x + i) in row y
+static inline void putMask(const pat_target_t* t, tile_cache_t* cache, uint32_t x, uint32_t y, uint8_t mask)
+{
+	uint32_t c = x % TORUS_TILE, i;
+
+	if (!t) {
+		return;
+	}
+	if (t->torus && c <= TORUS_TILE - 8) {	// all in one tile, without branches
+		uint64_t* col = writeTile(t, cache, x / TORUS_TILE, y / TORUS_TILE) + c;
+		uint32_t r = y % TORUS_TILE;
+
+		for (i = 0; i < 8; i++) {
+			col[i] |= (uint64_t)((mask >> i) & 1) << r;
+		}
+		return;
+	}
+	for (i = 0; i < 8; i++) {
+		if ((mask >> i) & 1) {
+			putRun(t, cache, x, y, 1);
+		}
+		if (++x == t->width) {
+			x = 0;
+		}
+	}
+}
+
+
+/*======================================================================
+	Function:		parsePlaintext
+	Input:			file contents, target (NULL = size only), info
+	Output:			0 or -1
+	Description:	The plaintext format: comment lines (!Name: = name)
+					and one line per row with . (dead) and O or * (alive).
+					Rows are read 8 cells at a time where possible.
+======================================================================*/
+static int parsePlaintext(const char* p, const char* end, const pat_target_t* t, pat_info_t* info)
+{
+	uint32_t w = t ? t->width : 1, h = t ? t->height : 1;
+	uint32_t y = t ? t->y : 0;
+	uint64_t px, py = 0, run;
+	tile_cache_t cache = {NULL, 0, 0};
+
+	while (p < end) {
+		const char* eol = memchr(p, '\n', end - p);
+
+		if (!eol) {
+			eol = end;
+		}
+		if (*p == '!') {
+			if (eol - p > 6 && !memcmp(p, "!Name:", 6)) {
+				copyLine(info->name, PAT_NAME, p + 6, eol);
+			}
+			p = eol + 1;
+			continue;
+		}
+		for (px = 0; p < eol; ) {
+			int mask;
+
+			if (eol - p >= 8 && (mask = cells8(p)) >= 0) {
+				if (mask) {
+					putMask(t, &cache, t ? (t->x + px) % w : 0, y, mask);
+					info->cells += __builtin_popcount(mask);
+					if (px + 32 - __builtin_clz(mask) > info->width) {
+						info->width = px + 32 - __builtin_clz(mask);
+					}
+					info->height = py + 1;
+				}
+				px += 8;
+				p += 8;
+			}
+			else if (*p == 'O' || *p == '*') {
+				for (run = 0; p < eol && (*p == 'O' || *p == '*'); p++) {
+					run++;
+				}
+				putRun(t, &cache, t ? (t->x + px) % w : 0, y, run);
+				info->cells += run;
+				px += run;
+				if (px > info->width) info->width = px;
+				info->height = py + 1;
+			}
+			else if (*p == '.') {
+				px++;
+				p++;
+			}
+			else if (*p == '\r' || *p == ' ') {
+				p++;
+			}
+			else {
+				return fail("unexpected character '%c' in plaintext data", *p);
+			}
+		}
+		p = eol + 1;
+		py++;
+		if (++y == h) {
+			y = 0;
+		}
+	}
+	return 0;
+}
+
+
+static int mcInit(mc_tree_t* m)
+{
+	memset(m, 0, sizeof(*m));
+	m->size = 1024;
+	m->node = calloc(m->size, sizeof(mc_node_t));
+	if (!m->node) {
+		return -1;
+	}
+	m->node[0].empty = 1;				// node 0 = empty node of any level
+	m->count = 1;
+	return 0;
+}
+
+
+// new node, 0 = out of memory
+static uint32_t mcAdd(mc_tree_t* m)
+{
+	mc_node_t* node;
+
+	if (m->count == m->size) {
+		node = realloc(m->node, 2 * (size_t)m->size * sizeof(mc_node_t));
+		if (!node) {
+			return 0;
+		}
+		m->node = node;
+		m->size *= 2;
+	}
+	memset(&m->node[m->count], 0, sizeof(mc_node_t));
+	return m->count++;
+}
+
+
+// bounding box of a new node from its leaf bits or its children
+static void mcBox(mc_tree_t* m, mc_node_t* n)
+{
+	uint64_t half = (uint64_t)1 << (n->level - 1);
+	int c, i;
+
+	n->empty = 1;
+	n->x0 = n->y0 = UINT64_MAX;
+	n->x1 = n->y1 = 0;
+	if (n->level == MC_LEAF) {
+		uint8_t rows = 0;
+
+		if (n->leaf) {
+			for (c = 0; c < 8; c++) {
+				rows |= n->leaf >> (8 * c);
+			}
+			n->x0 = __builtin_ctzll(n->leaf) / 8;
+			n->x1 = 7 - __builtin_clzll(n->leaf) / 8;
+			n->y0 = __builtin_ctz(rows);
+			n->y1 = 31 - __builtin_clz(rows);
+			n->empty = 0;
+		}
+		return;
+	}
+	for (i = 0; i < 4; i++) {
+		const mc_node_t* ch = &m->node[n->child[i]];
+		uint64_t dx = (i & 1) ? half : 0, dy = (i & 2) ? half : 0;
+
+		if (ch->empty) {
+			continue;
+		}
+		if (ch->x0 + dx < n->x0) n->x0 = ch->x0 + dx;
+		if (ch->x1 + dx > n->x1) n->x1 = ch->x1 + dx;
+		if (ch->y0 + dy < n->y0) n->y0 = ch->y0 + dy;
+		if (ch->y1 + dy > n->y1) n->y1 = ch->y1 + dy;
+		n->empty = 0;
+	}
+}
+
+
+// draw a node with its top left corner at (x, y), the bounding box of the root at the target position
+static void mcRender(mc_tree_t* m, uint32_t id, uint64_t x, uint64_t y, const pat_target_t* t, pat_info_t* info)
+{
+	const mc_node_t* n = &m->node[id];
+	uint64_t half;
+	int i;
+
+	if (n->empty) {
+		return;
+	}
+	if (n->level == MC_LEAF) {
+		for (i = 0; i < 8; i++) {
+			uint64_t bits = (n->leaf >> (8 * i)) & 0xFF;
+			uint64_t row = y;
+
+			if (bits) {
+				info->cells += __builtin_popcountll(bits);
+				if (row < m->y0) {		// the rows above the bounding box are dead
+					bits >>= m->y0 - row;
+					row = m->y0;
+				}
+				if (t) {
+					putBits(t, &m->cache, (t->x + (x + i - m->x0) % t->width) % t->width,
+						(t->y + (row - m->y0) % t->height) % t->height, bits);
+				}
+			}
+		}
+		return;
+	}
+	half = (uint64_t)1 << (n->level - 1);
+	for (i = 0; i < 4; i++) {
+		mcRender(m, n->child[i], x + ((i & 1) ? half : 0), y + ((i & 2) ? half : 0), t, info);
+	}
+}
+
+
+/*======================================================================
+	Function:		parseMacrocell
+	Input:			file contents, target (NULL = size only), info
+	Output:			0 or -1
+	Description:	The macrocell format [M2]: one line per node of a
+					quadtree, leaves of 8 x 8 cells ('.' / '*' rows, each
+					ended by '$') and nodes "level nw ne sw se" which refer
+					to earlier lines (1 = first node, 0 = empty). The last
+					node is the root. The bounding box of the live cells is
+					placed at the target position.
+======================================================================*/
+static int parseMacrocell(const char* p, const char* end, const pat_target_t* t, pat_info_t* info)
+{
+	mc_tree_t m;
+	mc_node_t* n;
+	uint32_t id = 0;
+	int ret = 0;
+
+	if (end - p < 4 || memcmp(p, "[M2]", 4)) {
+		return fail("macrocell data without [M2] header");
+	}
+	if (mcInit(&m)) {
+		return fail("out of memory");
+	}
+	p = nextLine(p, end);
+	while (p < end && !ret) {
+		const char* eol = nextLine(p, end);
+
+		if (*p == '#') {
+			if (p + 1 < end && p[1] == 'R') {
+				copyLine(info->rule, PAT_RULE, p + 2, eol);
+			}
+			else if (p + 1 < end && p[1] == 'N') {
+				copyLine(info->name, PAT_NAME, p + 2, eol);
+			}
+		}
+		else if (*p == '.' || *p == '*' || *p == '$') {
+			uint32_t c = 0, r = 0;
+
+			if (!(id = mcAdd(&m))) {
+				ret = fail("out of memory");
+				break;
+			}
+			n = &m.node[id];
+			n->level = MC_LEAF;
+			for (; p < eol && *p != '\n' && *p != '\r'; p++) {
+				if (*p == '$') {
+					r++;
+					c = 0;
+				}
+				else if (r < 8 && c < 8) {
+					if (*p == '*') {
+						n->leaf |= (uint64_t)1 << (8 * c + r);
+					}
+					c++;
+				}
+			}
+			mcBox(&m, n);
+		}
+		else if (*p >= '0' && *p <= '9') {
+			uint64_t v[5];
+			uint32_t level, ch[4];
+			int i;
+
+			for (i = 0; i < 5; i++) {	// level nw ne sw se
+				while (p < eol && *p == ' ') {
+					p++;
+				}
+				if (p == eol || *p < '0' || *p > '9') {
+					break;
+				}
+				for (v[i] = 0; p < eol && *p >= '0' && *p <= '9'; p++) {
+					v[i] = v[i] * 10 + (*p - '0');
+				}
+			}
+			if (i < 5 || v[0] <= MC_LEAF || v[0] > MC_MAX_LEVEL) {
+				ret = fail("unsupported macrocell node %u", m.count);
+				break;
+			}
+			level = v[0];
+			for (i = 0; i < 4; i++) {
+				ch[i] = (v[i + 1] < UINT32_MAX) ? v[i + 1] : UINT32_MAX;
+			}
+			if (!(id = mcAdd(&m))) {
+				ret = fail("out of memory");
+				break;
+			}
+			n = &m.node[id];
+			n->level = level;
+			for (i = 0; i < 4; i++) {
+				if (ch[i] >= id || (ch[i] && m.node[ch[i]].level != level - 1)) {
+					ret = fail("macrocell node %u refers to an invalid node", id);
+					break;
+				}
+				n->child[i] = ch[i];
+			}
+			mcBox(&m, n);
+		}
+		p = eol;
+	}
+	if (!ret && id) {
+		n = &m.node[id];
+		if (!n->empty) {
+			info->width = n->x1 - n->x0 + 1;
+			info->height = n->y1 - n->y0 + 1;
+			m.x0 = n->x0;
+			m.y0 = n->y0;
+			mcRender(&m, id, 0, 0, t, info);
+		}
+	}
+	free(m.node);
+	return ret;
+}
+
+
+/*======================================================================
+	Function:		patParse
+	Input:			file contents, format (-1 = detect), target (NULL =
+					only fill in info), info (output)
+	Output:			0 or -1 (see patError)
+	Description:	Decode a pattern into a world. The live cells are or-ed
+					into the target, so clear it first if necessary.
+======================================================================*/
+int patParse(const char* data, size_t size, int format, const pat_target_t* t, pat_info_t* info)
+{
+	const char* end = data + size;
+
+	memset(info, 0, sizeof(*info));
+	if (t && t->cols && t->height > 8) {
+		return fail("column bytes hold up to 8 rows");
+	}
+	if (format < 0) {
+		const char* p = data;
+
+		while (p < end && *p == '#') {
+			p = nextLine(p, end);
+		}
+		if (size >= 4 && !memcmp(data, "[M2]", 4)) {
+			format = PAT_MACROCELL;
+		}
+		else if (p < end && *p == 'x') {
+			format = PAT_RLE;
+		}
+		else {
+			format = PAT_PLAINTEXT;
+		}
+	}
+	switch (format) {
+		case PAT_RLE:
+			return parseRle(data, end, t, info);
+		case PAT_PLAINTEXT:
+			return parsePlaintext(data, end, t, info);
+		case PAT_MACROCELL:
+			return parseMacrocell(data, end, t, info);
+	}
+	return fail("unknown format");
+}
+
+
+/*======================================================================
+	Function:		patLoad
+	Input:			file name, target (NULL = only fill in info), info
+	Output:			0 or -1 (see patError)
+	Description:	Memory map a pattern file and decode it (the format
+					follows from the extension or the contents).
+======================================================================*/
+int patLoad(const char* file, const pat_target_t* t, pat_info_t* info)
+{
+	struct stat st;
+	void* data;
+	int fd, ret;
+
+	if ((fd = open(file, O_RDONLY)) < 0 || fstat(fd, &st)) {
+		if (fd >= 0) {
+			close(fd);
+		}
+		return fail("%s: %s", file, strerror(errno));
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return fail("%s: empty file", file);
+	}
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return fail("%s: %s", file, strerror(errno));
+	}
+	madvise(data, st.st_size, MADV_SEQUENTIAL);
+	ret = patParse(data, st.st_size, patFormat(file), t, info);
+	munmap(data, st.st_size);
+	return ret;
+}
+
+
+// bounding box of the live cells (width 0 = no live cells)
+static int liveBox(const pat_target_t* t, box_t* box)
+{
+	uint8_t* row = malloc(t->width);
+	uint32_t x, y, x0 = t->width, x1 = 0;
+
+	if (!row) {
+		return fail("out of memory");
+	}
+	memset(box, 0, sizeof(*box));
+	for (y = 0; y < t->height; y++) {
+		getRow(t, y, row);
+		for (x = 0; x < t->width && !row[x]; x++)
+			;
+		if (x == t->width) {
+			continue;
+		}
+		if (x < x0) x0 = x;
+		for (x = t->width - 1; !row[x]; x--)
+			;
+		if (x > x1) x1 = x;
+		if (!box->height) {
+			box->y = y;
+		}
+		box->height = y - box->y + 1;
+	}
+	if (box->height) {
+		box->x = x0;
+		box->width = x1 - x0 + 1;
+	}
+	free(row);
+	return 0;
+}
+
+
+static void rleItem(FILE* f, int* len, uint64_t n, char c)
+{
+	char item[24];
+	char* q = item + sizeof(item);
+	int k;
+
+	*--q = c;
+	if (n > 1) {
+		for (; n; n /= 10) {
+			*--q = '0' + n % 10;
+		}
+	}
+	k = item + sizeof(item) - q;
+	if (*len + k > RLE_LINE) {
+		putc('\n', f);
+		*len = 0;
+	}
+	fwrite(q, 1, k, f);
+	*len += k;
+}
+
+
+static int saveRle(FILE* f, const pat_target_t* t, const box_t* box, const pat_info_t* info)
+{
+	uint8_t* row = malloc(t->width);
+	uint64_t rows = 0;					// pending end of row marks
+	uint32_t x, y, run, end = box->x + box->width;
+	int len = 0;
+
+	if (!row) {
+		return fail("out of memory");
+	}
+	fprintf(f, "x = %u, y = %u, rule = %s\n", box->width, box->height, info->rule[0] ? info->rule : "B3/S23");
+	for (y = box->y; y < box->y + box->height; y++) {
+		getRow(t, y, row);
+		for (x = box->x; x < end; ) {
+			uint8_t alive = row[x];
+
+			for (run = 0; x < end && row[x] == alive; x++) {
+				run++;
+			}
+			if (alive || x < end) {		// dead cells at the end of a row are left out
+				if (rows) {
+					rleItem(f, &len, rows, '$');
+					rows = 0;
+				}
+				rleItem(f, &len, run, alive ? 'o' : 'b');
+			}
+		}
+		rows++;
+	}
+	rleItem(f, &len, 1, '!');
+	fputc('\n', f);
+	free(row);
+	return 0;
+}
+
+
+static int savePlaintext(FILE* f, const pat_target_t* t, const box_t* box)
+{
+	uint8_t* row = malloc(t->width);
+	char* line = malloc(box->width + 1);
+	uint32_t x, y, n;
+
+	if (!row || !line) {
+		free(row);
+		free(line);
+		return fail("out of memory");
+	}
+	for (y = box->y; y < box->y + box->height; y++) {
+		getRow(t, y, row);
+		for (x = n = 0; x < box->width; x++) {
+			line[x] = row[box->x + x] ? 'O' : '.';
+			if (row[box->x + x]) {
+				n = x + 1;				// dots at the end of a line are left out
+			}
+		}
+		line[n] = '\n';
+		fwrite(line, 1, n + 1, f);
+	}
+	free(row);
+	free(line);
+	return 0;
+}
+
+
+static uint64_t mcHash(const mc_node_t* n)
+{
+	uint64_t h = n->leaf * 0x9E3779B97F4A7C15ull ^ n->level;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		h = (h ^ n->child[i]) * 0xFF51AFD7ED558CCDull;
+	}
+	return h ^ (h >> 29);
+}
+
+
+// find or add a node, new nodes are written at once (children always come first)
+static uint32_t mcIntern(mc_tree_t* m, const mc_node_t* n)
+{
+	uint32_t slot = mcHash(n) & (m->hash_size - 1), id, i, r;
+
+	while ((id = m->hash[slot])) {
+		const mc_node_t* o = &m->node[id];
+
+		if (o->level == n->level && o->leaf == n->leaf && !memcmp(o->child, n->child, sizeof(n->child))) {
+			return id;
+		}
+		slot = (slot + 1) & (m->hash_size - 1);
+	}
+	if (2 * m->count >= m->hash_size) {	// grow the table and insert again
+		free(m->hash);
+		m->hash_size *= 2;
+		m->hash = calloc(m->hash_size, sizeof(uint32_t));
+		if (!m->hash) {
+			fprintf(stderr, "patio: out of memory\n");
+			exit(1);
+		}
+		for (i = 1; i < m->count; i++) {
+			slot = mcHash(&m->node[i]) & (m->hash_size - 1);
+			while (m->hash[slot]) {
+				slot = (slot + 1) & (m->hash_size - 1);
+			}
+			m->hash[slot] = i;
+		}
+		return mcIntern(m, n);
+	}
+	if (!(id = mcAdd(m))) {
+		fprintf(stderr, "patio: out of memory\n");
+		exit(1);
+	}
+	m->node[id] = *n;
+	m->hash[slot] = id;
+	if (n->level == MC_LEAF) {
+		for (r = 0; r < 8; r++) {
+			uint32_t c, last = 0;
+
+			for (c = 0; c < 8; c++) {
+				if ((n->leaf >> (8 * c + r)) & 1) {
+					last = c + 1;
+				}
+			}
+			for (c = 0; c < last; c++) {
+				fputc(((n->leaf >> (8 * c + r)) & 1) ? '*' : '.', m->f);
+			}
+			fputc('$', m->f);
+		}
+		fputc('\n', m->f);
+	}
+	else {
+		fprintf(m->f, "%u %u %u %u %u\n", n->level, n->child[0], n->child[1], n->child[2], n->child[3]);
+	}
+	return id;
+}
+
+
+static uint32_t mcBuild(mc_tree_t* m, const pat_target_t* t, int level, uint32_t x, uint32_t y)
+{
+	mc_node_t n;
+	uint32_t half;
+	int i;
+
+	memset(&n, 0, sizeof(n));
+	n.level = level;
+	if (x >= m->box.width || y >= m->box.height) {
+		return 0;
+	}
+	if (level == MC_LEAF) {
+		for (i = 0; i < 8 && x + i < m->box.width; i++) {
+			n.leaf |= getBits(t, m->box.x + x + i, m->box.y + y, (m->box.height - y < 8) ? m->box.height - y : 8) << (8 * i);
+		}
+		return n.leaf ? mcIntern(m, &n) : 0;
+	}
+	half = (uint32_t)1 << (level - 1);
+	for (i = 0; i < 4; i++) {
+		n.child[i] = mcBuild(m, t, level - 1, x + ((i & 1) ? half : 0), y + ((i & 2) ? half : 0));
+	}
+	if (!(n.child[0] | n.child[1] | n.child[2] | n.child[3])) {
+		return 0;
+	}
+	return mcIntern(m, &n);
+}
+
+
+static int saveMacrocell(FILE* f, const pat_target_t* t, const box_t* box, const pat_info_t* info)
+{
+	mc_tree_t m;
+	int level = MC_LEAF;
+
+	while (((uint64_t)1 << level) < box->width || ((uint64_t)1 << level) < box->height) {
+		level++;
+	}
+	if (mcInit(&m)) {
+		return fail("out of memory");
+	}
+	m.box = *box;
+	m.f = f;
+	m.hash_size = 1024;
+	m.hash = calloc(m.hash_size, sizeof(uint32_t));
+	if (!m.hash) {
+		free(m.node);
+		return fail("out of memory");
+	}
+	fprintf(f, "[M2] (hacklace patio)\n#R %s\n", info->rule[0] ? info->rule : "B3/S23");
+	if (info->name[0]) {
+		fprintf(f, "#N %s\n", info->name);
+	}
+	if (!mcBuild(&m, t, level, 0, 0)) {
+		fprintf(f, "$\n");				// empty world: a single dead leaf
+	}
+	free(m.hash);
+	free(m.node);
+	return 0;
+}
+
+
+/*======================================================================
+	Function:		patSave
+	Input:			file name, format (PAT_...), world, info (name and
+					rule, may be NULL)
+	Output:			0 or -1 (see patError)
+	Description:	Write the bounding box of the live cells of a world as
+					a pattern file.
+======================================================================*/
+int patSave(const char* file, int format, const pat_target_t* t, const pat_info_t* info)
+{
+	static const pat_info_t none;
+	FILE* f;
+	box_t box;
+	int ret = 0;
+
+	if (liveBox(t, &box)) {
+		return -1;
+	}
+	if (!(f = fopen(file, "w"))) {
+		return fail("%s: %s", file, strerror(errno));
+	}
+	if (!info) {
+		info = &none;
+	}
+	switch (format) {
+		case PAT_RLE:
+			if (info->name[0]) {
+				fprintf(f, "#N %s\n", info->name);
+			}
+			ret = saveRle(f, t, &box, info);
+			break;
+		case PAT_PLAINTEXT:
+			if (info->name[0]) {
+				fprintf(f, "!Name: %s\n", info->name);
+			}
+			ret = savePlaintext(f, t, &box);
+			break;
+		case PAT_MACROCELL:
+			ret = saveMacrocell(f, t, &box, info);
+			break;
+		default:
+			ret = fail("unknown format");
+	}
+	if (fclose(f) && !ret) {
+		ret = fail("%s: %s", file, strerror(errno));
+	}
+	return ret;
+}
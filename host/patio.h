@@ -0,0 +1,86 @@
+/*
+ * patio.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Pattern import and export for the host tools. Reads and
+					writes Life patterns in the RLE, plaintext and macrocell
+					formats. Input files are memory mapped and parsed in a
+					single pass straight into the layout of the engine: the
+					column bytes of the display memory or the 64 bit tile
+					columns of a torus (torus.h). Cells outside the world wrap
+					around like in the game.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+
+#ifndef PATIO_H_
+#define PATIO_H_
+
+#include "torus.h"
+
+
+/*************
+ * constants *
+ *************/
+
+// file formats
+#define PAT_RLE				0			// run length encoded (.rle)
+#define PAT_PLAINTEXT		1			// one line per row, . = dead, O = alive (.cells)
+#define PAT_MACROCELL		2			// quadtree of 8 x 8 leaves (.mc)
+
+#define PAT_NAME			64
+#define PAT_RULE			32
+
+
+/*********
+ * types *
+ *********/
+
+// world a pattern is loaded into or saved from: either column bytes like
+// display.memory (bit y = row y, up to 8 rows) or a torus
+typedef struct {
+	uint8_t* cols;						// column bytes or NULL
+	torus_t* torus;						// torus or NULL
+	uint32_t width, height;				// size of the world (set by patTarget...)
+	uint32_t x, y;						// position of the top left cell of the pattern
+} pat_target_t;
+
+typedef struct {
+	char name[PAT_NAME];				// #N / !Name: line, empty if none
+	char rule[PAT_RULE];				// rule of the RLE header or #R line, empty if none
+	uint32_t width, height;				// size of the pattern
+	uint64_t cells;						// number of live cells
+} pat_info_t;
+
+
+/**************
+ * prototypes *
+ **************/
+pat_target_t patTargetCols(uint8_t* cols, uint32_t width, uint32_t height);
+pat_target_t patTargetTorus(torus_t* t);
+int patFormat(const char* file);
+int patParse(const char* data, size_t size, int format, const pat_target_t* t, pat_info_t* info);
+int patLoad(const char* file, const pat_target_t* t, pat_info_t* info);
+int patSave(const char* file, int format, const pat_target_t* t, const pat_info_t* info);
+const char* patError(void);
+
+
+#endif /* PATIO_H_ */
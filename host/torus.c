@@ -0,0 +1,466 @@
+/*
+ * torus.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Tiled, multithreaded game of life engine for large tori,
+					see torus.h
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dot_matrix.h"
+#include "life.h"
+#include "torus.h"
+
+
+#if (LIFE_BIRTH != (1<<3)) || (LIFE_SURVIVE != ((1<<2)|(1<<3)))
+	#error "The torus engine implements Conway's rule (B3/S23) only"
+#endif
+
+
+/*********
+ * types *
+ *********/
+
+// tiles [next, end) of the active list, owned by one worker but open to stealing
+typedef struct {
+	_Alignas(64) atomic_uint next;
+	uint32_t end;
+} range_t;
+
+typedef struct {
+	torus_t* t;
+	int self;
+} worker_t;
+
+struct torus {
+	uint32_t width, height;
+	uint32_t tiles_x, tiles_y;
+	uint32_t tiles;
+	uint64_t* buf[2];					// tiles of the current and the next generation
+	uint8_t* changed[2];				// per tile: changed in the current / next generation
+	uint8_t* mark;						// scratch for building the active list
+	uint32_t* active;					// tiles to compute in this generation
+	uint32_t active_count;
+	int cur;							// index of the current generation in buf / changed
+	uint64_t generation;
+	int threads;
+	range_t* ranges;
+	worker_t* workers;
+	pthread_t* tid;
+	pthread_barrier_t start, done;
+	int quit;
+};
+
+
+/**********
+ * makros *
+ **********/
+
+#define TILE_INDEX(t, tx, ty)	((ty) * (t)->tiles_x + (tx))
+#define TILE_WORDS				TORUS_TILE
+#define MAJ(a, b, c)			(((a) & (b)) | ((c) & ((a) ^ (b))))
+
+
+/*************
+ * functions *
+ *************/
+
+/*======================================================================
+	Function:		torusStepTile
+	Input:			torus, tile index
+	Output:			1 if the tile has changed
+	Description:	Compute the next generation of one tile. The 64 columns
+					plus one halo column on either side are shifted up and
+					down with the border rows of the tiles above and below,
+					and the neighbours are counted bit parallel with the
+					adder network of the rows kernel (8 neighbours plus the
+					centre cell, see lifeStepRows).
+======================================================================*/
+static uint8_t torusStepTile(const torus_t* t, uint32_t tile)
+{
+	const uint64_t* src = t->buf[t->cur];
+	uint64_t* dst = t->buf[t->cur ^ 1] + (size_t)tile * TILE_WORDS;
+	uint32_t tx = tile % t->tiles_x, ty = tile / t->tiles_x;
+	uint32_t xl = tx ? tx - 1 : t->tiles_x - 1;
+	uint32_t xr = (tx + 1 == t->tiles_x) ? 0 : tx + 1;
+	uint32_t yu = ty ? ty - 1 : t->tiles_y - 1;
+	uint32_t yd = (ty + 1 == t->tiles_y) ? 0 : ty + 1;
+	const uint64_t* column[3], *above[3], *below[3];
+	uint64_t v0[TILE_WORDS + 2], v1[TILE_WORDS + 2];
+	uint64_t diff = 0;
+	int i;
+
+	// left halo, tile, right halo
+	column[0] = src + (size_t)TILE_INDEX(t, xl, ty) * TILE_WORDS;
+	column[1] = src + (size_t)TILE_INDEX(t, tx, ty) * TILE_WORDS;
+	column[2] = src + (size_t)TILE_INDEX(t, xr, ty) * TILE_WORDS;
+	above[0] = src + (size_t)TILE_INDEX(t, xl, yu) * TILE_WORDS;
+	above[1] = src + (size_t)TILE_INDEX(t, tx, yu) * TILE_WORDS;
+	above[2] = src + (size_t)TILE_INDEX(t, xr, yu) * TILE_WORDS;
+	below[0] = src + (size_t)TILE_INDEX(t, xl, yd) * TILE_WORDS;
+	below[1] = src + (size_t)TILE_INDEX(t, tx, yd) * TILE_WORDS;
+	below[2] = src + (size_t)TILE_INDEX(t, xr, yd) * TILE_WORDS;
+
+	// vertical sums of three cells (bit 0 and bit 1) for every column
+	for (i = 0; i < TILE_WORDS + 2; i++) {
+		int part = (i == 0) ? 0 : ((i == TILE_WORDS + 1) ? 2 : 1);
+		int x = (i == 0) ? TILE_WORDS - 1 : ((i == TILE_WORDS + 1) ? 0 : i - 1);
+		uint64_t c = column[part][x];
+		uint64_t u = (c << 1) | (above[part][x] >> (TORUS_TILE - 1));
+		uint64_t d = (c >> 1) | (below[part][x] << (TORUS_TILE - 1));
+
+		v0[i] = u ^ c ^ d;
+		v1[i] = MAJ(u, c, d);
+	}
+
+	// sum of the 3x3 block: s0 + 2 * (l1 + c1 + r1 + k1)
+	for (i = 1; i <= TILE_WORDS; i++) {
+		uint64_t l0 = v0[i - 1], c0 = v0[i], r0 = v0[i + 1];
+		uint64_t s0 = l0 ^ c0 ^ r0;
+		uint64_t k1 = MAJ(l0, c0, r0);
+		uint64_t p = v1[i - 1] ^ v1[i], q = v1[i - 1] & v1[i];
+		uint64_t r = v1[i + 1] ^ k1, u = v1[i + 1] & k1;
+		uint64_t low = ~(q | u);
+		uint64_t one = (p ^ r) & low;
+		uint64_t two = (p & r & low) | ((q ^ u) & ~(p | r));
+		uint64_t next = (s0 & one) | (~s0 & two & column[1][i - 1]);	// 3, or 4 including a live centre
+
+		diff |= next ^ column[1][i - 1];
+		dst[i - 1] = next;
+	}
+	return diff != 0;
+}
+
+
+/*======================================================================
+	Function:		torusWork
+	Input:			torus, worker number
+	Output:			none
+	Description:	Compute the tiles of the own range first, then steal
+					tiles from the ranges of the other workers.
+======================================================================*/
+static void torusWork(torus_t* t, int self)
+{
+	uint8_t* changed = t->changed[t->cur ^ 1];
+	uint32_t n;
+	int i;
+
+	for (i = 0; i < t->threads; i++) {
+		range_t* r = &t->ranges[(self + i) % t->threads];
+
+		while ((n = atomic_fetch_add_explicit(&r->next, 1, memory_order_relaxed)) < r->end) {
+			uint32_t tile = t->active[n];
+
+			changed[tile] = torusStepTile(t, tile);
+		}
+	}
+}
+
+
+static void* torusWorker(void* arg)
+{
+	worker_t* w = arg;
+	torus_t* t = w->t;
+
+	while (1) {
+		pthread_barrier_wait(&t->start);
+		if (t->quit) {
+			break;
+		}
+		torusWork(t, w->self);
+		pthread_barrier_wait(&t->done);
+	}
+	return NULL;
+}
+
+
+/*======================================================================
+	Function:		torusBuildActive
+	Input:			torus
+	Output:			none
+	Description:	Collect the tiles that have changed in the current
+					generation together with their 8 neighbours. Every other
+					tile holds the same cells in both buffers and is skipped.
+======================================================================*/
+static void torusBuildActive(torus_t* t)
+{
+	const uint8_t* changed = t->changed[t->cur];
+	uint32_t tx, ty, i;
+	int dx, dy;
+
+	memset(t->mark, 0, t->tiles);
+	for (ty = 0; ty < t->tiles_y; ty++) {
+		for (tx = 0; tx < t->tiles_x; tx++) {
+			if (!changed[TILE_INDEX(t, tx, ty)]) {
+				continue;
+			}
+			for (dy = -1; dy <= 1; dy++) {
+				uint32_t y = (ty + t->tiles_y + dy) % t->tiles_y;
+
+				for (dx = -1; dx <= 1; dx++) {
+					t->mark[TILE_INDEX(t, (tx + t->tiles_x + dx) % t->tiles_x, y)] = 1;
+				}
+			}
+		}
+	}
+	t->active_count = 0;
+	for (i = 0; i < t->tiles; i++) {
+		if (t->mark[i]) {
+			t->active[t->active_count++] = i;
+		}
+	}
+}
+
+
+/*======================================================================
+	Function:		torusCreate
+	Input:			width and height in cells (multiples of TORUS_TILE),
+					number of threads
+	Output:			new empty torus, NULL on error
+	Description:	.
+======================================================================*/
+torus_t* torusCreate(uint32_t width, uint32_t height, int threads)
+{
+	torus_t* t;
+	int i;
+
+	if (width == 0 || height == 0 || width % TORUS_TILE || height % TORUS_TILE || threads < 1) {
+		return NULL;
+	}
+	t = calloc(1, sizeof(torus_t));
+	if (!t) {
+		return NULL;
+	}
+	t->width = width;
+	t->height = height;
+	t->tiles_x = width / TORUS_TILE;
+	t->tiles_y = height / TORUS_TILE;
+	t->tiles = t->tiles_x * t->tiles_y;
+	t->threads = threads;
+	for (i = 0; i < 2; i++) {
+		t->buf[i] = aligned_alloc(64, (size_t)t->tiles * TILE_WORDS * sizeof(uint64_t));
+		t->changed[i] = calloc(t->tiles, 1);
+	}
+	t->mark = malloc(t->tiles);
+	t->active = malloc((size_t)t->tiles * sizeof(uint32_t));
+	t->ranges = aligned_alloc(64, threads * sizeof(range_t));
+	t->workers = calloc(threads, sizeof(worker_t));
+	t->tid = calloc(threads, sizeof(pthread_t));
+	if (!t->buf[0] || !t->buf[1] || !t->changed[0] || !t->changed[1] || !t->mark
+			|| !t->active || !t->ranges || !t->workers || !t->tid) {
+		t->threads = 1;					// no worker threads and barriers yet
+		free(t->tid);
+		t->tid = NULL;
+		torusDestroy(t);
+		return NULL;
+	}
+	torusClear(t);
+
+	// worker 0 is the calling thread
+	pthread_barrier_init(&t->start, NULL, threads);
+	pthread_barrier_init(&t->done, NULL, threads);
+	for (i = 1; i < threads; i++) {
+		t->workers[i].t = t;
+		t->workers[i].self = i;
+		pthread_create(&t->tid[i], NULL, torusWorker, &t->workers[i]);
+	}
+	return t;
+}
+
+
+void torusDestroy(torus_t* t)
+{
+	int i;
+
+	if (t->threads > 1) {
+		t->quit = 1;
+		pthread_barrier_wait(&t->start);
+		for (i = 1; i < t->threads; i++) {
+			pthread_join(t->tid[i], NULL);
+		}
+	}
+	if (t->tid) {
+		pthread_barrier_destroy(&t->start);
+		pthread_barrier_destroy(&t->done);
+	}
+	for (i = 0; i < 2; i++) {
+		free(t->buf[i]);
+		free(t->changed[i]);
+	}
+	free(t->mark);
+	free(t->active);
+	free(t->ranges);
+	free(t->workers);
+	free(t->tid);
+	free(t);
+}
+
+
+uint32_t torusWidth(const torus_t* t)
+{
+	return t->width;
+}
+
+
+uint32_t torusHeight(const torus_t* t)
+{
+	return t->height;
+}
+
+
+/*======================================================================
+	Function:		torusClear
+	Input:			torus
+	Output:			none
+	Description:	Kill all cells and reset the generation counter.
+======================================================================*/
+void torusClear(torus_t* t)
+{
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		memset(t->buf[i], 0, (size_t)t->tiles * TILE_WORDS * sizeof(uint64_t));
+		memset(t->changed[i], 0, t->tiles);
+	}
+	t->active_count = 0;
+	t->generation = 0;
+}
+
+
+void torusSetCell(torus_t* t, uint32_t x, uint32_t y, uint8_t alive)
+{
+	uint64_t* col = torusTile(t, x / TORUS_TILE, y / TORUS_TILE) + x % TORUS_TILE;
+	uint64_t bit = (uint64_t)1 << (y % TORUS_TILE);
+
+	if (alive) {
+		*col |= bit;
+	}
+	else {
+		*col &= ~bit;
+	}
+	torusTouch(t, x / TORUS_TILE, y / TORUS_TILE);
+}
+
+
+uint8_t torusGetCell(const torus_t* t, uint32_t x, uint32_t y)
+{
+	const uint64_t* tile = t->buf[t->cur] + (size_t)TILE_INDEX(t, x / TORUS_TILE, y / TORUS_TILE) * TILE_WORDS;
+
+	return (tile[x % TORUS_TILE] >> (y % TORUS_TILE)) & 1;
+}
+
+
+/*======================================================================
+	Function:		torusTile
+	Input:			torus, tile coordinates
+	Output:			the TORUS_TILE columns of the tile in the current generation
+	Description:	Direct access to a tile, e. g. for loading patterns.
+					Call torusTouch() after modifying it.
+======================================================================*/
+uint64_t* torusTile(torus_t* t, uint32_t tx, uint32_t ty)
+{
+	return t->buf[t->cur] + (size_t)TILE_INDEX(t, tx, ty) * TILE_WORDS;
+}
+
+
+/*======================================================================
+	Function:		torusTouch
+	Input:			torus, tile coordinates
+	Output:			none
+	Description:	Mark a modified tile, so that it and its neighbours are
+					computed in the next generation.
+======================================================================*/
+void torusTouch(torus_t* t, uint32_t tx, uint32_t ty)
+{
+	t->changed[t->cur][TILE_INDEX(t, tx, ty)] = 1;
+}
+
+
+/*======================================================================
+	Function:		torusStep
+	Input:			torus, number of generations
+	Output:			none
+	Description:	Advance the world. The active tiles are split into one
+					contiguous range per thread (which keeps neighbouring
+					tiles on the same core), and a thread that runs out of
+					work continues with the remaining tiles of the others.
+======================================================================*/
+void torusStep(torus_t* t, long gens)
+{
+	long g;
+	int i;
+
+	for (g = 0; g < gens; g++) {
+		torusBuildActive(t);
+		memset(t->changed[t->cur ^ 1], 0, t->tiles);
+		for (i = 0; i < t->threads; i++) {
+			atomic_store_explicit(&t->ranges[i].next,
+				(uint64_t)t->active_count * i / t->threads, memory_order_relaxed);
+			t->ranges[i].end = (uint64_t)t->active_count * (i + 1) / t->threads;
+		}
+		if (t->threads > 1) {
+			pthread_barrier_wait(&t->start);
+			torusWork(t, 0);
+			pthread_barrier_wait(&t->done);
+		}
+		else {
+			torusWork(t, 0);
+		}
+		t->cur ^= 1;
+		t->generation++;
+	}
+}
+
+
+uint64_t torusPopulation(const torus_t* t)
+{
+	const uint64_t* w = t->buf[t->cur];
+	size_t i, n = (size_t)t->tiles * TILE_WORDS;
+	uint64_t pop = 0;
+
+	for (i = 0; i < n; i++) {
+		pop += __builtin_popcountll(w[i]);
+	}
+	return pop;
+}
+
+
+uint64_t torusGeneration(const torus_t* t)
+{
+	return t->generation;
+}
+
+
+/*======================================================================
+	Function:		torusActiveTiles
+	Input:			torus
+	Output:			number of tiles computed in the last generation
+	Description:	.
+======================================================================*/
+uint32_t torusActiveTiles(const torus_t* t)
+{
+	return t->active_count;
+}
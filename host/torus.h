@@ -0,0 +1,71 @@
+/*
+ * torus.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Tiled, multithreaded game of life engine for large tori on
+					the host. The world is split into tiles of 64 x 64 cells
+					which use the column layout of the display memory: every
+					column of a tile is a 64 bit word (8 bytes, 8 rows per byte,
+					bit 0 of byte 0 = top row). Only tiles next to a change of
+					the previous generation are computed, and the tiles are
+					distributed over a pool of threads which steal work from
+					each other.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+
+#ifndef TORUS_H_
+#define TORUS_H_
+
+
+/*************
+ * constants *
+ *************/
+
+#define TORUS_TILE			64			// tile size in columns and rows (do not change)
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct torus torus_t;
+
+
+/**************
+ * prototypes *
+ **************/
+torus_t* torusCreate(uint32_t width, uint32_t height, int threads);
+void torusDestroy(torus_t* t);
+uint32_t torusWidth(const torus_t* t);
+uint32_t torusHeight(const torus_t* t);
+void torusClear(torus_t* t);
+void torusSetCell(torus_t* t, uint32_t x, uint32_t y, uint8_t alive);
+uint8_t torusGetCell(const torus_t* t, uint32_t x, uint32_t y);
+uint64_t* torusTile(torus_t* t, uint32_t tx, uint32_t ty);
+void torusTouch(torus_t* t, uint32_t tx, uint32_t ty);
+void torusStep(torus_t* t, long gens);
+uint64_t torusPopulation(const torus_t* t);
+uint64_t torusGeneration(const torus_t* t);
+uint32_t torusActiveTiles(const torus_t* t);
+
+
+#endif /* TORUS_H_ */
@@ -0,0 +1,594 @@
+/*
+ * trace.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Frame traces of the host tools (see trace.h). File layout
+					(numbers little endian):
+						header: "HLTRACE1", frames (8 bytes), offset of the
+						index (8 bytes), frames per keyframe (4 bytes),
+						columns, rows, generations per frame, 0
+						blocks: keyframe (1 byte per column), flags (bit 0 =
+						reseed, bit 1 = equal to its predecessor), the
+						predicted delta bit of every neighbourhood (64
+						bytes), then the range coded deltas of the
+						following frames up to the next keyframe
+						index: offset of every block (8 bytes)
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace.h"
+
+
+/*************
+ * constants *
+ *************/
+
+#define HEADER_SIZE		32
+#define FLAG_RESEED		0x01
+#define FLAG_STILL		0x02
+#define PROB_BITS		16				// precision of the probabilities
+#define PROB_ADAPT		4				// adaptation speed (higher = slower)
+#define RANGE_TOP		(1UL << 24)		// the range is kept above this limit
+#define PREDICT_MISS	256				// initial probability of a delta bit against the prediction
+#define CONTEXTS		512				// 3 x 3 neighbourhoods
+
+static const char magic[8] = "HLTRACE1";
+
+
+/*********
+ * types *
+ *********/
+
+// probability of a 0 bit in 1 / 2^PROB_BITS
+typedef struct {
+	uint16_t delta[2][CONTEXTS];		// [reseed][3 x 3 neighbourhood in the previous frame]
+	uint16_t reseed[2];					// [previous frame equal to its predecessor]
+} model_t;
+
+// binary range coder (carry propagation like in LZMA)
+typedef struct {
+	uint64_t low;						// encoder
+	uint64_t pending;					// encoder: bytes held back for a carry
+	uint8_t cache;						// encoder: first of these bytes
+	uint32_t range;
+	uint32_t code;						// decoder
+	const uint8_t* in;					// decoder input
+	const uint8_t* end;
+} coder_t;
+
+struct trace {
+	trace_info_t info;
+	FILE* f;							// writer
+	uint64_t offset;					// writer: bytes written so far
+	uint64_t* blocks;					// writer: offsets of the blocks
+	uint64_t blocks_alloc;
+	uint32_t ones[CONTEXTS];			// writer: delta bits = 1 per neighbourhood (computed frames)
+	uint32_t seen[CONTEXTS];			// writer: delta bits per neighbourhood
+	uint8_t predict[CONTEXTS / 8];		// predicted delta bits of the current block
+	const uint8_t* data;				// reader: mapped file
+	uint64_t pos;						// number of the next frame
+	uint8_t frame[TRACE_MAX_COLS];		// previous frame
+	uint8_t still;						// previous frame equal to its predecessor
+	model_t model;
+	coder_t coder;
+};
+
+
+/********************
+ * global variables *
+ ********************/
+
+static char error[256];
+
+
+/*************
+ * functions *
+ *************/
+
+static int fail(const char* fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(error, sizeof(error), fmt, ap);
+	va_end(ap);
+	return -1;
+}
+
+
+const char* traceError(void)
+{
+	return error;
+}
+
+
+static void putLe(uint8_t* p, uint64_t v, int n)
+{
+	while (n--) {
+		*p++ = v;
+		v >>= 8;
+	}
+}
+
+
+static uint64_t getLe(const uint8_t* p, int n)
+{
+	uint64_t v = 0;
+
+	while (n--) {
+		v = (v << 8) | p[n];
+	}
+	return v;
+}
+
+
+// start of a block: the deltas of computed frames are expected to follow the
+// prediction of the block (i. e. the rule), everything else is unknown
+static void modelReset(model_t* m, const uint8_t* predict)
+{
+	uint16_t i;
+
+	for (i = 0; i < CONTEXTS; i++) {
+		m->delta[0][i] = ((predict[i / 8] >> (i % 8)) & 1) ? PREDICT_MISS : (1 << PROB_BITS) - PREDICT_MISS;
+		m->delta[1][i] = 1 << (PROB_BITS - 1);
+	}
+	m->reseed[0] = m->reseed[1] = 1 << (PROB_BITS - 1);
+}
+
+
+// column with the wrapped rows above and below: bits y .. y + 2 = rows y - 1 .. y + 1
+static inline uint16_t extend(uint8_t col, uint8_t rows)
+{
+	return (col << 1) | ((col >> (rows - 1)) & 1) | ((col & 1) << (rows + 1));
+}
+
+
+// 3 x 3 neighbourhood of every cell, 9 bits per cell (column x * rows + y)
+static void neighbourhoods(const uint8_t* frame, uint8_t cols, uint8_t rows, uint16_t* ctx)
+{
+	uint16_t e[TRACE_MAX_COLS + 2];
+	uint8_t x, y;
+
+	for (x = 0; x < cols; x++) {
+		e[x + 1] = extend(frame[x], rows);
+	}
+	e[0] = e[cols];
+	e[cols + 1] = e[1];
+	for (x = 0; x < cols; x++) {
+		for (y = 0; y < rows; y++) {
+			*ctx++ = ((e[x] >> y) & 7) | (((e[x + 1] >> y) & 7) << 3) | (((e[x + 2] >> y) & 7) << 6);
+		}
+	}
+}
+
+
+static void putByte(trace_t* t, uint8_t b)
+{
+	putc(b, t->f);
+	t->offset++;
+}
+
+
+static void encShift(trace_t* t)
+{
+	coder_t* c = &t->coder;
+
+	if ((uint32_t)c->low < 0xFF000000UL || (c->low >> 32)) {
+		uint8_t carry = c->low >> 32;
+		uint8_t b = c->cache;
+
+		do {
+			putByte(t, b + carry);
+			b = 0xFF;
+		} while (--c->pending);
+		c->cache = c->low >> 24;
+	}
+	c->pending++;
+	c->low = (c->low & 0x00FFFFFF) << 8;
+}
+
+
+static inline void encBit(trace_t* t, uint16_t* p, uint8_t bit)
+{
+	coder_t* c = &t->coder;
+	uint32_t bound = (c->range >> PROB_BITS) * *p;
+
+	if (bit) {
+		c->low += bound;
+		c->range -= bound;
+		*p -= *p >> PROB_ADAPT;
+	}
+	else {
+		c->range = bound;
+		*p += ((1 << PROB_BITS) - *p) >> PROB_ADAPT;
+	}
+	while (c->range < RANGE_TOP) {
+		c->range <<= 8;
+		encShift(t);
+	}
+}
+
+
+static void encFlush(trace_t* t)
+{
+	int i;
+
+	for (i = 0; i < 5; i++) {
+		encShift(t);
+	}
+}
+
+
+/*======================================================================
+	Function:		traceCreate
+	Input:			file name, columns and rows of a frame, generations per
+					frame, frames per keyframe (0 = TRACE_INTERVAL)
+	Output:			trace or NULL (see traceError)
+	Description:	Create a trace file. Frames are added with traceAppend,
+					traceClose writes the index.
+======================================================================*/
+trace_t* traceCreate(const char* file, uint8_t cols, uint8_t rows, uint8_t gens, uint32_t interval)
+{
+	uint8_t header[HEADER_SIZE] = {0};
+	trace_t* t;
+
+	if (cols < 1 || cols > TRACE_MAX_COLS || rows < 1 || rows > 8) {
+		fail("frames of %u x %u cells are not supported", cols, rows);
+		return NULL;
+	}
+	if (!(t = calloc(1, sizeof(*t)))) {
+		fail("out of memory");
+		return NULL;
+	}
+	t->info.cols = cols;
+	t->info.rows = rows;
+	t->info.gens = gens;
+	t->info.interval = interval ? interval : TRACE_INTERVAL;
+	if (!(t->f = fopen(file, "wb"))) {
+		fail("%s: %s", file, strerror(errno));
+		free(t);
+		return NULL;
+	}
+	fwrite(header, 1, HEADER_SIZE, t->f);		// filled in by traceClose
+	t->offset = HEADER_SIZE;
+	return t;
+}
+
+
+/*======================================================================
+	Function:		traceAppend
+	Input:			trace, frame (columns), 1 if the frame has been seeded
+					instead of computed
+	Output:			0 or -1 (see traceError)
+	Description:	Add the next frame. Every bit of the XOR with the
+					previous frame is coded with the probability of the 3 x 3
+					neighbourhood of the cell, so cells which follow the rule
+					cost a small fraction of a bit.
+======================================================================*/
+int traceAppend(trace_t* t, const uint8_t* frame, uint8_t reseed)
+{
+	uint16_t ctx[TRACE_MAX_COLS * 8];
+	uint8_t cols = t->info.cols, rows = t->info.rows;
+	uint8_t x, y, diff, still = !memcmp(frame, t->frame, cols);
+	uint16_t* p;
+	uint16_t i;
+
+	if (t->info.frames % t->info.interval == 0) {
+		if (t->info.frames) {
+			encFlush(t);
+		}
+		if (t->info.frames / t->info.interval == t->blocks_alloc) {
+			uint64_t* b = realloc(t->blocks, 2 * (t->blocks_alloc + 16) * sizeof(*b));
+
+			if (!b) {
+				return fail("out of memory");
+			}
+			t->blocks = b;
+			t->blocks_alloc = 2 * (t->blocks_alloc + 16);
+		}
+		t->blocks[t->info.frames / t->info.interval] = t->offset;
+		for (x = 0; x < cols; x++) {
+			putByte(t, frame[x]);
+		}
+		putByte(t, (reseed ? FLAG_RESEED : 0) | ((still && t->info.frames) ? FLAG_STILL : 0));
+		memset(t->predict, 0, sizeof(t->predict));
+		for (i = 0; i < CONTEXTS; i++) {
+			if (2 * t->ones[i] > t->seen[i]) {	// majority of all frames so far
+				t->predict[i / 8] |= 1 << (i % 8);
+			}
+		}
+		for (i = 0; i < sizeof(t->predict); i++) {
+			putByte(t, t->predict[i]);
+		}
+		modelReset(&t->model, t->predict);
+		memset(&t->coder, 0, sizeof(t->coder));
+		t->coder.range = 0xFFFFFFFFUL;
+		t->coder.pending = 1;
+	}
+	else {
+		encBit(t, &t->model.reseed[t->still], reseed);
+		p = t->model.delta[reseed != 0];
+		neighbourhoods(t->frame, cols, rows, ctx);
+		for (x = 0; x < cols; x++) {
+			diff = frame[x] ^ t->frame[x];
+			for (y = 0; y < rows; y++) {
+				i = ctx[x * rows + y];
+				encBit(t, &p[i], (diff >> y) & 1);
+				if (!reseed) {
+					t->ones[i] += (diff >> y) & 1;
+					t->seen[i]++;
+				}
+			}
+		}
+	}
+	memcpy(t->frame, frame, cols);
+	t->still = still;
+	t->info.frames++;
+	return ferror(t->f) ? fail("write error: %s", strerror(errno)) : 0;
+}
+
+
+/*======================================================================
+	Function:		traceClose
+	Input:			trace (created by traceCreate or opened by traceOpen)
+	Output:			0 or -1 (see traceError)
+	Description:	Write the index and the header and free the trace.
+======================================================================*/
+int traceClose(trace_t* t)
+{
+	uint8_t buf[HEADER_SIZE];
+	uint64_t i, n;
+	int ret = 0;
+
+	if (t->data) {
+		munmap((void*)t->data, t->info.bytes);
+		free(t);
+		return 0;
+	}
+	if (t->info.frames) {
+		encFlush(t);
+	}
+	n = (t->info.frames + t->info.interval - 1) / t->info.interval;
+	memcpy(buf, magic, 8);
+	putLe(buf + 8, t->info.frames, 8);
+	putLe(buf + 16, t->offset, 8);
+	putLe(buf + 24, t->info.interval, 4);
+	buf[28] = t->info.cols;
+	buf[29] = t->info.rows;
+	buf[30] = t->info.gens;
+	buf[31] = 0;
+	for (i = 0; i < n; i++) {
+		uint8_t b[8];
+
+		putLe(b, t->blocks[i], 8);
+		fwrite(b, 1, 8, t->f);
+	}
+	if (fseek(t->f, 0, SEEK_SET) || fwrite(buf, 1, HEADER_SIZE, t->f) != HEADER_SIZE || ferror(t->f)) {
+		ret = fail("write error: %s", strerror(errno));
+	}
+	if (fclose(t->f)) {
+		ret = fail("write error: %s", strerror(errno));
+	}
+	free(t->blocks);
+	free(t);
+	return ret;
+}
+
+
+static inline uint8_t decBit(coder_t* c, uint16_t* p)
+{
+	uint32_t bound = (c->range >> PROB_BITS) * *p;
+	uint8_t bit;
+
+	if (c->code < bound) {
+		c->range = bound;
+		*p += ((1 << PROB_BITS) - *p) >> PROB_ADAPT;
+		bit = 0;
+	}
+	else {
+		c->code -= bound;
+		c->range -= bound;
+		*p -= *p >> PROB_ADAPT;
+		bit = 1;
+	}
+	while (c->range < RANGE_TOP) {
+		c->range <<= 8;
+		c->code = (c->code << 8) | ((c->in < c->end) ? *c->in++ : 0);
+	}
+	return bit;
+}
+
+
+/*======================================================================
+	Function:		traceOpen
+	Input:			file name
+	Output:			trace or NULL (see traceError)
+	Description:	Map a trace file into memory and check its header and
+					index. The trace is positioned at the first frame.
+======================================================================*/
+trace_t* traceOpen(const char* file)
+{
+	struct stat st;
+	const uint8_t* d;
+	trace_t* t;
+	uint64_t index, n, i;
+	void* data;
+	int fd;
+
+	if ((fd = open(file, O_RDONLY)) < 0 || fstat(fd, &st)) {
+		if (fd >= 0) {
+			close(fd);
+		}
+		fail("%s: %s", file, strerror(errno));
+		return NULL;
+	}
+	if (st.st_size < HEADER_SIZE) {
+		close(fd);
+		fail("%s: not a trace", file);
+		return NULL;
+	}
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		fail("%s: %s", file, strerror(errno));
+		return NULL;
+	}
+	d = data;
+	if (!(t = calloc(1, sizeof(*t)))) {
+		munmap(data, st.st_size);
+		fail("out of memory");
+		return NULL;
+	}
+	t->data = d;
+	t->info.bytes = st.st_size;
+	t->info.frames = getLe(d + 8, 8);
+	t->info.interval = getLe(d + 24, 4);
+	t->info.cols = d[28];
+	t->info.rows = d[29];
+	t->info.gens = d[30];
+	index = getLe(d + 16, 8);
+	if (memcmp(d, magic, 8) || !t->info.interval || !t->info.cols || t->info.cols > TRACE_MAX_COLS
+			|| !t->info.rows || t->info.rows > 8 || index < HEADER_SIZE) {
+		traceClose(t);
+		fail("%s: not a trace", file);
+		return NULL;
+	}
+	n = (t->info.frames + t->info.interval - 1) / t->info.interval;
+	if (index > t->info.bytes || (t->info.bytes - index) / 8 < n) {
+		traceClose(t);
+		fail("%s: truncated", file);
+		return NULL;
+	}
+	for (i = 0; i < n; i++) {
+		uint64_t b = getLe(d + index + 8 * i, 8);
+
+		if (b < HEADER_SIZE || b + t->info.cols + 1 + CONTEXTS / 8 > index || (i && b <= getLe(d + index + 8 * (i - 1), 8))) {
+			traceClose(t);
+			fail("%s: corrupt index", file);
+			return NULL;
+		}
+	}
+	madvise(data, st.st_size, MADV_RANDOM);
+	return t;
+}
+
+
+void traceInfo(const trace_t* t, trace_info_t* info)
+{
+	*info = t->info;
+}
+
+
+/*======================================================================
+	Function:		traceNext
+	Input:			trace, frame (output, columns), reseed flag (output,
+					may be NULL)
+	Output:			1 = frame read, 0 = end of the trace
+	Description:	Read the next frame: a keyframe is copied, any other
+					frame is decoded from its predecessor.
+======================================================================*/
+int traceNext(trace_t* t, uint8_t* frame, uint8_t* reseed)
+{
+	uint16_t ctx[TRACE_MAX_COLS * 8];
+	uint8_t cols = t->info.cols, rows = t->info.rows;
+	uint8_t x, y, diff, r;
+	uint16_t* p;
+
+	if (t->pos >= t->info.frames) {
+		return 0;
+	}
+	if (t->pos % t->info.interval == 0) {
+		uint64_t index = getLe(t->data + 16, 8);
+		uint64_t block = t->pos / t->info.interval;
+		const uint8_t* b = t->data + getLe(t->data + index + 8 * block, 8);
+		int i;
+
+		memcpy(t->frame, b, cols);
+		r = b[cols] & FLAG_RESEED;
+		t->still = (b[cols] & FLAG_STILL) != 0;
+		modelReset(&t->model, b + cols + 1);
+		memset(&t->coder, 0, sizeof(t->coder));
+		t->coder.range = 0xFFFFFFFFUL;
+		t->coder.in = b + cols + 1 + CONTEXTS / 8;
+		t->coder.end = (t->pos + t->info.interval < t->info.frames)
+			? t->data + getLe(t->data + index + 8 * (block + 1), 8) : t->data + index;
+		for (i = 0; i < 5; i++) {
+			t->coder.code = (t->coder.code << 8) | ((t->coder.in < t->coder.end) ? *t->coder.in++ : 0);
+		}
+	}
+	else {
+		r = decBit(&t->coder, &t->model.reseed[t->still]);
+		p = t->model.delta[r];
+		neighbourhoods(t->frame, cols, rows, ctx);
+		t->still = 1;
+		for (x = 0; x < cols; x++) {
+			diff = 0;
+			for (y = 0; y < rows; y++) {
+				diff |= decBit(&t->coder, &p[ctx[x * rows + y]]) << y;
+			}
+			if (diff) {
+				t->frame[x] ^= diff;
+				t->still = 0;
+			}
+		}
+	}
+	memcpy(frame, t->frame, cols);
+	if (reseed) {
+		*reseed = r;
+	}
+	t->pos++;
+	return 1;
+}
+
+
+/*======================================================================
+	Function:		traceSeek
+	Input:			trace, frame number
+	Output:			0 or -1 (see traceError)
+	Description:	Position the trace so that traceNext returns the given
+					frame: decoding starts at the keyframe before it, or at
+					the current position if that is closer.
+======================================================================*/
+int traceSeek(trace_t* t, uint64_t frame)
+{
+	uint8_t buf[TRACE_MAX_COLS];
+
+	if (frame >= t->info.frames) {
+		return fail("frame %" PRIu64 " is beyond the end of the trace (%" PRIu64 " frames)", frame, t->info.frames);
+	}
+	if (frame < t->pos || frame / t->info.interval != t->pos / t->info.interval) {
+		t->pos = frame - frame % t->info.interval;
+	}
+	while (t->pos < frame) {
+		traceNext(t, buf, NULL);
+	}
+	return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * trace.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Frame traces of the host tools. A trace stores every frame
+					of a run (the column bytes of display.memory, bit y =
+					row y) together with the reseed events. Every
+					TRACE_INTERVAL frames a keyframe is stored as is, the
+					frames in between as the XOR with their predecessor. Every
+					bit of a delta is range coded with an adaptive probability
+					selected by the 3 x 3 neighbourhood of the cell in the
+					previous frame, so that the transitions of the rule cost
+					next to nothing and only reseeds (and kernel errors) take
+					space. An index of the keyframes at the end of the file
+					gives random access to any frame, the reader maps the file
+					into memory.
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+
+/*************
+ * constants *
+ *************/
+
+#define TRACE_INTERVAL		4096		// default number of frames per keyframe
+#define TRACE_MAX_COLS		240			// DISP_MAX limit
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct trace trace_t;
+
+typedef struct {
+	uint8_t cols, rows;					// size of a frame
+	uint8_t gens;						// generations per frame
+	uint32_t interval;					// frames per keyframe
+	uint64_t frames;					// number of frames
+	uint64_t bytes;						// size of the file
+} trace_info_t;
+
+
+/**************
+ * prototypes *
+ **************/
+trace_t* traceCreate(const char* file, uint8_t cols, uint8_t rows, uint8_t gens, uint32_t interval);
+int traceAppend(trace_t* t, const uint8_t* frame, uint8_t reseed);
+int traceClose(trace_t* t);
+trace_t* traceOpen(const char* file);
+void traceInfo(const trace_t* t, trace_info_t* info);
+int traceSeek(trace_t* t, uint64_t frame);
+int traceNext(trace_t* t, uint8_t* frame, uint8_t* reseed);
+const char* traceError(void);
+
+
+#endif /* TRACE_H_ */
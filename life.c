@@ -0,0 +1,416 @@
+/*
+ * life.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Generation kernels for Conway's game of life (C implementations)
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+#include "dot_matrix.h"
+#include "life.h"
+#if LIFE_RULE_TABLE
+	#include "life_rules.h"
+#endif
+
+
+/**********
+ * makros *
+ **********/
+
+#ifndef _BV
+	#define _BV(bit)	(1 << (bit))
+#endif
+
+#define LUT_BYTE(n)			(LIFE_LUT_BIT(8*(n)) | LIFE_LUT_BIT(8*(n)+1) << 1 | LIFE_LUT_BIT(8*(n)+2) << 2 \
+							| LIFE_LUT_BIT(8*(n)+3) << 3 | LIFE_LUT_BIT(8*(n)+4) << 4 | LIFE_LUT_BIT(8*(n)+5) << 5 \
+							| LIFE_LUT_BIT(8*(n)+6) << 6 | LIFE_LUT_BIT(8*(n)+7) << 7)
+#define LUT_8_BYTES(n)		LUT_BYTE(n), LUT_BYTE(n+1), LUT_BYTE(n+2), LUT_BYTE(n+3), \
+							LUT_BYTE(n+4), LUT_BYTE(n+5), LUT_BYTE(n+6), LUT_BYTE(n+7)
+
+
+/********************
+ * global variables *
+ ********************/
+
+static uint8_t samecnt = 0;				// number of still life generations
+static uint16_t animcnt = 0;			// number of generations since the last reseed
+
+#if LIFE_RULE_TABLE
+uint16_t life_birth = LIFE_BIRTH;		// current rule (see LIFE_RULE_TABLE)
+uint16_t life_survive = LIFE_SURVIVE;
+static uint8_t life_rule = 0;			// next entry of life_rules
+#endif
+
+#if (LIFE_KERNEL == LIFE_KERNEL_LUT) || ((LIFE_GENERATIONS > 1) && !LIFE_CONWAY) || !defined(__AVR__)
+// next state of every 3x3 neighbourhood (see LIFE_LUT_BIT), computed by the compiler
+// (used by lifeStepLut and by lifeNextColumn for rules other than Conway's)
+const uint8_t life_lut[64] PROGMEM = {
+	LUT_8_BYTES(0),  LUT_8_BYTES(8),  LUT_8_BYTES(16), LUT_8_BYTES(24),
+	LUT_8_BYTES(32), LUT_8_BYTES(40), LUT_8_BYTES(48), LUT_8_BYTES(56)
+};
+#endif
+
+
+/*************
+ * functions *
+ *************/
+
+/*======================================================================
+	Function:		lifeResetCounters
+	Input:			none
+	Output:			none
+	Description:	Reset the reseed bookkeeping (see lifeReseedDue).
+======================================================================*/
+void lifeResetCounters(void)
+{
+	samecnt = 0;
+	animcnt = 0;
+}
+
+
+/*======================================================================
+	Function:		lifeReseedDue
+	Input:			1 = last generation did not change the world
+	Output:			1 = world should be replaced by a new one
+	Description:	Reseed bookkeeping, call once per generation. A still life
+					is replaced after LIFE_STILL_GENS generations, any world
+					(including oscillators) after LIFE_MAX_GENS generations.
+======================================================================*/
+uint8_t lifeReseedDue(uint8_t still)
+{
+	uint8_t reseed = 0;
+
+	if (still) {
+		if (++samecnt == LIFE_STILL_GENS) {
+			samecnt = 0;
+			animcnt = 0;
+			reseed = 1;
+		}
+	}
+	if (++animcnt == LIFE_MAX_GENS) {
+		animcnt = 0;
+		reseed = 1;
+	}
+	return reseed;
+}
+
+
+#if LIFE_RULE_TABLE
+/*======================================================================
+	Function:		lifeNextRule
+	Input:			none
+	Output:			none
+	Description:	Switch to the next rule of the table in life_rules.h.
+					Call it whenever a new world is seeded.
+======================================================================*/
+void lifeNextRule(void)
+{
+	life_birth = pgm_read_word(&life_rules[life_rule][0]);
+	life_survive = pgm_read_word(&life_rules[life_rule][1]);
+	if (++life_rule == LIFE_RULES) {
+		life_rule = 0;
+	}
+}
+#endif
+
+
+#if (LIFE_KERNEL == LIFE_KERNEL_C) || !defined(__AVR__)
+/*======================================================================
+	Function:		lifeStepRef
+	Input:			destination buffer
+					source buffer
+					number of columns
+	Output:			none
+	Description:	Reference kernel. Counts the live neighbours of every
+					cell individually. Slow, but obviously correct.
+======================================================================*/
+void lifeStepRef(uint8_t* dst, const uint8_t* src, uint8_t cols)
+{
+	uint8_t x, y;
+	uint8_t l, r, t, b;
+	uint8_t live_neighbours;
+
+	for (x = 0; x < cols; x++) {
+
+		l = (x == 0) ? (cols - 1) : (x - 1);
+		r = (x == (cols - 1)) ? 0 : (x + 1);
+
+		dst[x] = 0;
+
+		for (y = 0; y < DISP_ROWS; y++) {
+
+			t = (y == 0) ? (DISP_ROWS - 1) : (y - 1);
+			b = (y == (DISP_ROWS - 1)) ? 0 : (y + 1);
+
+			live_neighbours =
+				((src[l] & _BV(t)) > 0) +
+				((src[l] & _BV(y)) > 0) +
+				((src[l] & _BV(b)) > 0) +
+				((src[x] & _BV(t)) > 0) +
+				((src[x] & _BV(b)) > 0) +
+				((src[r] & _BV(t)) > 0) +
+				((src[r] & _BV(y)) > 0) +
+				((src[r] & _BV(b)) > 0);
+
+			if ((src[x] & _BV(y)) ? (LIFE_RULE_SURVIVE & _BV(live_neighbours))
+					: (LIFE_RULE_BIRTH & _BV(live_neighbours)))
+				dst[x] |= _BV(y);
+
+		}
+	}
+}
+#endif
+
+
+#if (LIFE_KERNEL == LIFE_KERNEL_LUT) || !defined(__AVR__)
+/*======================================================================
+	Function:		lifeStepLut
+	Input:			destination buffer
+					source buffer
+					number of columns
+	Output:			none
+	Description:	Table driven kernel. A 3x3 window slides down each column,
+					its 9 bits index the next state in life_lut. Works for any
+					rule as the table is built from LIFE_BIRTH / LIFE_SURVIVE.
+======================================================================*/
+void lifeStepLut(uint8_t* dst, const uint8_t* src, uint8_t cols)
+{
+	uint8_t x, y;
+	uint8_t next;
+	uint16_t l, c, r;
+	uint16_t idx;
+
+	for (x = 0; x < cols; x++) {
+		l = LIFE_WRAP_COLUMN(src[(x == 0) ? (cols - 1) : (x - 1)]);
+		c = LIFE_WRAP_COLUMN(src[x]);
+		r = LIFE_WRAP_COLUMN(src[(x == (cols - 1)) ? 0 : (x + 1)]);
+		next = 0;
+
+		for (y = 0; y < DISP_ROWS; y++) {
+			idx = (l & 7) | (c & 7) << 3 | (r & 7) << 6;
+			if (pgm_read_byte(&life_lut[idx >> 3]) & _BV(idx & 7)) {
+				next |= _BV(y);
+			}
+			l >>= 1;
+			c >>= 1;
+			r >>= 1;
+		}
+		dst[x] = next;
+	}
+}
+#endif
+
+
+#if (LIFE_KERNEL == LIFE_KERNEL_ROWS) || !defined(__AVR__)
+/*======================================================================
+	Function:		lifeStepRows
+	Input:			destination buffer
+					source buffer
+					number of columns
+	Output:			none
+	Description:	Row major kernel. The world is transposed into rows of
+					8 cells per byte, so the horizontal neighbours are mere
+					shifts and the adder network handles 8 cells per
+					operation. The result is transposed back into columns
+					for the display. For worlds of up to 8 columns a row is
+					a single byte.
+======================================================================*/
+void lifeStepRows(uint8_t* dst, const uint8_t* src, uint8_t cols)
+{
+	uint8_t rows[DISP_ROWS][LIFE_ROW_BYTES_MAX];
+	uint8_t pair0[DISP_ROWS][LIFE_ROW_BYTES_MAX];	// left + right cell, bit 0
+	uint8_t pair1[DISP_ROWS][LIFE_ROW_BYTES_MAX];	// left + right cell, bit 1
+	uint8_t nbytes = (cols + 7) / 8;
+	uint8_t last = nbytes - 1;
+	uint8_t last_bit = _BV((cols - 1) & 7);
+	uint8_t x, y, k, i;
+	uint8_t t, b;
+	uint8_t w, c, e;
+	uint8_t t0, t1, b0, b1;
+	uint8_t x0, x1, x2, carry;
+
+	// transpose columns -> rows
+	for (y = 0; y < DISP_ROWS; y++) {
+		for (k = 0; k < nbytes; k++) {
+			rows[y][k] = 0;
+		}
+	}
+	for (x = 0; x < cols; x++) {
+		for (y = 0; y < DISP_ROWS; y++) {
+			if (src[x] & _BV(y)) {
+				rows[y][x >> 3] |= _BV(x & 7);
+			}
+		}
+		dst[x] = 0;
+	}
+
+	// horizontal neighbours of every cell
+	for (y = 0; y < DISP_ROWS; y++) {
+		for (k = 0; k < nbytes; k++) {
+			c = rows[y][k];
+			w = c << 1;								// w: cell to the left
+			if (k > 0) {
+				w |= rows[y][k - 1] >> 7;
+			}
+			else if (rows[y][last] & last_bit) {
+				w |= 1;								// wrap around
+			}
+			e = c >> 1;								// e: cell to the right
+			if (k < last) {
+				e |= rows[y][k + 1] << 7;
+			}
+			else if (rows[y][0] & 1) {
+				e |= last_bit;						// wrap around
+			}
+			pair0[y][k] = w ^ e;
+			pair1[y][k] = w & e;
+		}
+	}
+
+	// row above (3 cells) + row below (3 cells) + own row (2 cells)
+	for (y = 0; y < DISP_ROWS; y++) {
+		t = (y == 0) ? (DISP_ROWS - 1) : (y - 1);
+		b = (y == (DISP_ROWS - 1)) ? 0 : (y + 1);
+		for (k = 0; k < nbytes; k++) {
+			t0 = pair0[t][k] ^ rows[t][k];
+			t1 = pair1[t][k] | (pair0[t][k] & rows[t][k]);
+			b0 = pair0[b][k] ^ rows[b][k];
+			b1 = pair1[b][k] | (pair0[b][k] & rows[b][k]);
+
+			x0 = t0 ^ b0;
+			carry = t0 & b0;
+			x2 = (t1 & b1) | ((t1 ^ b1) & carry);
+			x1 = t1 ^ b1 ^ carry;
+
+			carry = x0 & pair0[y][k];
+			x0 ^= pair0[y][k];
+			x2 ^= (x1 & pair1[y][k]) | ((x1 ^ pair1[y][k]) & carry);
+			x1 ^= pair1[y][k] ^ carry;
+
+			c = x1 & ~x2 & (x0 | rows[y][k]);		// next state of 8 cells
+			if (k == last) {
+				c &= (last_bit << 1) - 1;			// the unused bits have garbage neighbours
+			}
+
+			// transpose rows -> columns
+			for (i = 0; c; i++, c >>= 1) {
+				if (c & 1) {
+					dst[(k << 3) + i] |= _BV(y);
+				}
+			}
+		}
+	}
+}
+#endif
+
+
+#if (LIFE_GENERATIONS > 1) || !defined(__AVR__)
+/*======================================================================
+	Function:		lifeNextColumn
+	Input:			left, own and right column
+	Output:			next state of the own column
+	Description:	Next state of a single column. Uses the bit parallel
+					adder network of lifeStepAsm for Conway's rule and the
+					lookup table otherwise.
+======================================================================*/
+static inline uint8_t lifeNextColumn(uint8_t l, uint8_t c, uint8_t r)
+{
+#if LIFE_CONWAY
+	uint16_t wl = LIFE_WRAP_COLUMN(l), wc = LIFE_WRAP_COLUMN(c), wr = LIFE_WRAP_COLUMN(r);
+	uint8_t la = wl, lb = wl >> 2, ca = wc, cb = wc >> 2, ra = wr, rb = wr >> 2;	// row above / below
+	uint8_t l0, l1, r0, r1, c0, c1, x0, x1, x2, carry;
+
+	l0 = la ^ lb ^ l;  l1 = (la & lb) | ((la ^ lb) & l);
+	r0 = ra ^ rb ^ r;  r1 = (ra & rb) | ((ra ^ rb) & r);
+	c0 = ca ^ cb;      c1 = ca & cb;
+
+	x0 = l0 ^ r0;  carry = l0 & r0;
+	x2 = (l1 & r1) | ((l1 ^ r1) & carry);
+	x1 = l1 ^ r1 ^ carry;
+	carry = x0 & c0;  x0 ^= c0;
+	x2 ^= (x1 & c1) | ((x1 ^ c1) & carry);
+	x1 ^= c1 ^ carry;
+
+	return x1 & ~x2 & (x0 | c) & ((1 << DISP_ROWS) - 1);
+#else
+	uint16_t wl = LIFE_WRAP_COLUMN(l), wc = LIFE_WRAP_COLUMN(c), wr = LIFE_WRAP_COLUMN(r);
+	uint16_t idx;
+	uint8_t y, next = 0;
+
+	for (y = 0; y < DISP_ROWS; y++) {
+		idx = ((wl >> y) & 7) | ((wc >> y) & 7) << 3 | ((wr >> y) & 7) << 6;
+		if (pgm_read_byte(&life_lut[idx >> 3]) & _BV(idx & 7)) {
+			next |= _BV(y);
+		}
+	}
+	return next;
+#endif
+}
+
+
+/*======================================================================
+	Function:		lifeStepBlocked
+	Input:			destination buffer
+					source buffer
+					number of columns
+					number of generations (1..LIFE_BLOCK_MAX)
+	Output:			none
+	Description:	Advance the world by several generations in one sweep
+					(temporal blocking). Every generation keeps a window of
+					its last three columns. A new source column ripples
+					through the windows, producing one column of every
+					following generation, so each column is read and written
+					once per sweep instead of once per generation.
+					To close the torus the sweep starts 'gens' columns before
+					column 0 and ends 'gens' columns after the last one.
+======================================================================*/
+void lifeStepBlocked(uint8_t* dst, const uint8_t* src, uint8_t cols, uint8_t gens)
+{
+	uint8_t win[LIFE_BLOCK_MAX][3];			// last three columns of every generation (0 = oldest)
+	uint8_t fill[LIFE_BLOCK_MAX];			// number of valid columns in win
+	int16_t v;
+	uint8_t g, col;
+
+	for (g = 0; g < gens; g++) {
+		fill[g] = 0;
+	}
+	for (v = -gens; v < cols + gens; v++) {
+		col = src[(v + cols * (uint16_t)gens) % cols];
+		for (g = 0; g < gens; g++) {
+			win[g][0] = win[g][1];
+			win[g][1] = win[g][2];
+			win[g][2] = col;
+			if (fill[g] < 3) {
+				fill[g]++;
+			}
+			if (fill[g] < 3) {
+				break;
+			}
+			col = lifeNextColumn(win[g][0], win[g][1], win[g][2]);	// column v - g - 1 of generation g + 1
+		}
+		if (g == gens) {
+			dst[v - gens] = col;
+		}
+	}
+}
+#endif
@@ -0,0 +1,132 @@
+/*
+ * life.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Generation kernels for Conway's game of life
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+
+#ifndef LIFE_H_
+#define LIFE_H_
+
+
+/*************
+ * constants *
+ *************/
+
+// available generation kernels
+#define LIFE_KERNEL_C		0			// portable C reference (counts the neighbours of every cell)
+#define LIFE_KERNEL_ASM		1			// hand optimized assembler (bit parallel adder network, AVR only)
+#define LIFE_KERNEL_LUT		2			// lookup table with the next state of every 3x3 neighbourhood (64 bytes flash)
+#define LIFE_KERNEL_ROWS	3			// world transposed to rows, bit parallel adder network along the rows
+
+// rule (bit n set = a cell with n live neighbours is born / survives)
+#define LIFE_BIRTH			(1<<3)					// B3
+#define LIFE_SURVIVE		((1<<2)|(1<<3))			// S23 (Conway)
+#define LIFE_CONWAY			((LIFE_BIRTH == (1<<3)) && (LIFE_SURVIVE == ((1<<2)|(1<<3))))	// 1 = B3/S23 (for #if)
+
+// reseeding
+#define LIFE_STILL_GENS		32			// still life generations before a new world is seeded
+#define LIFE_MAX_GENS		1024		// generations after which any world is replaced
+
+// kernel used by dmScroll()
+#define LIFE_KERNEL			LIFE_KERNEL_C
+//#define LIFE_KERNEL			LIFE_KERNEL_ASM
+//#define LIFE_KERNEL			LIFE_KERNEL_LUT
+//#define LIFE_KERNEL			LIFE_KERNEL_ROWS
+
+// generations computed per scrolling step (> 1 = fast forward with lifeStepBlocked)
+#define LIFE_GENERATIONS	1
+#define LIFE_BLOCK_MAX		8			// maximum number of generations per lifeStepBlocked call
+
+// row major layout (LIFE_KERNEL_ROWS): 1 bit per cell, 8 columns per byte
+#ifdef __AVR__
+	#define LIFE_ROW_BYTES_MAX	((DISP_MAX + 7) / 8)
+#else
+	#define LIFE_ROW_BYTES_MAX	32		// host tools: up to 256 columns
+#endif
+
+// rule table: the C reference kernel reads the rule from life_birth / life_survive,
+// and every reseed switches to the next rule of life_rules.h (generated by host/liferules)
+#define LIFE_RULE_TABLE		0			// 1 = on
+
+#if LIFE_RULE_TABLE
+	#define LIFE_RULE_BIRTH		life_birth
+	#define LIFE_RULE_SURVIVE	life_survive
+	#if (LIFE_KERNEL != LIFE_KERNEL_C) || (LIFE_GENERATIONS > 1)
+		#error "The rule table needs LIFE_KERNEL_C and LIFE_GENERATIONS = 1"
+	#endif
+#else
+	#define LIFE_RULE_BIRTH		LIFE_BIRTH
+	#define LIFE_RULE_SURVIVE	LIFE_SURVIVE
+#endif
+
+#if ((LIFE_KERNEL == LIFE_KERNEL_ASM) || (LIFE_KERNEL == LIFE_KERNEL_ROWS)) && !LIFE_CONWAY
+	#error "The assembler and the row kernel only implement Conway's rule (B3/S23)"
+#endif
+
+// Next state of the centre cell of a 3x3 neighbourhood. Bits 0..2 of the index
+// are the left column (top to bottom), bits 3..5 the own column and bits 6..8
+// the right column. The centre cell is bit 4.
+#define LIFE_LUT_NEIGHBOURS(i)	(((i) & 1) + (((i) >> 1) & 1) + (((i) >> 2) & 1) + (((i) >> 3) & 1) \
+								+ (((i) >> 5) & 1) + (((i) >> 6) & 1) + (((i) >> 7) & 1) + (((i) >> 8) & 1))
+#define LIFE_LUT_BIT(i)			(((((i) >> 4) & 1) ? LIFE_SURVIVE : LIFE_BIRTH) >> LIFE_LUT_NEIGHBOURS(i) & 1)
+
+// column extended by the wrapped around rows: bit 0 = last row, bit DISP_ROWS + 1 = first row
+#define LIFE_WRAP_COLUMN(col)	((uint16_t)(col) << 1 | (col) >> (DISP_ROWS - 1) | (uint16_t)((col) & 1) << (DISP_ROWS + 1))
+
+
+/**************
+ * prototypes *
+ **************/
+#ifndef __ASSEMBLER__
+
+// All kernels compute the next generation of a torus with 'cols' columns
+// (1 byte = 1 column, DISP_ROWS rows) from src into dst. The buffers must not overlap.
+void lifeStepRef(uint8_t* dst, const uint8_t* src, uint8_t cols);
+void lifeStepAsm(uint8_t* dst, const uint8_t* src, uint8_t cols);
+void lifeStepLut(uint8_t* dst, const uint8_t* src, uint8_t cols);
+void lifeStepRows(uint8_t* dst, const uint8_t* src, uint8_t cols);
+void lifeStepBlocked(uint8_t* dst, const uint8_t* src, uint8_t cols, uint8_t gens);
+
+void lifeResetCounters(void);
+uint8_t lifeReseedDue(uint8_t still);
+
+#if LIFE_RULE_TABLE
+	extern uint16_t life_birth, life_survive;
+	void lifeNextRule(void);
+#endif
+
+#if LIFE_KERNEL == LIFE_KERNEL_ASM
+	#define lifeStep		lifeStepAsm
+#elif LIFE_KERNEL == LIFE_KERNEL_LUT
+	#define lifeStep		lifeStepLut
+#elif LIFE_KERNEL == LIFE_KERNEL_ROWS
+	#define lifeStep		lifeStepRows
+#else
+	#define lifeStep		lifeStepRef
+#endif
+
+#endif /* __ASSEMBLER__ */
+
+
+#endif /* LIFE_H_ */
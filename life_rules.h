@@ -0,0 +1,22 @@
+// generated by liferules -n 256 -g 1024 -s 1: the 16 best ranked rules of the 5x7 torus
+// score = mean transient * activity * (1 - dead soups) * (1 - soups without a cycle), B0 rules excluded
+#define LIFE_RULES		16
+
+const uint16_t life_rules[LIFE_RULES][2] PROGMEM = {	// birth and survival masks
+	{0x1f4, 0x114},	// B245678/S248     score 206.27, transient  452.7, activity 0.558
+	{0x0ee, 0x124},	// B123567/S258     score 204.24, transient  435.6, activity 0.569
+	{0x0dc, 0x1a4},	// B23467/S2578     score 202.35, transient  453.3, activity 0.506
+	{0x1f6, 0x115},	// B1245678/S0248   score 197.35, transient  393.6, activity 0.563
+	{0x1ae, 0x1a0},	// B123578/S578     score 196.80, transient  433.9, activity 0.560
+	{0x0da, 0x1a1},	// B13467/S0578     score 194.30, transient  391.4, activity 0.588
+	{0x05c, 0x1a1},	// B2346/S0578      score 191.87, transient  374.6, activity 0.612
+	{0x15e, 0x121},	// B123468/S058     score 188.90, transient  366.8, activity 0.623
+	{0x0da, 0x1a3},	// B13467/S01578    score 188.32, transient  478.8, activity 0.592
+	{0x02c, 0x161},	// B235/S0568       score 187.64, transient  420.3, activity 0.499
+	{0x1f2, 0x126},	// B145678/S1258    score 185.66, transient  384.3, activity 0.622
+	{0x15a, 0x122},	// B13468/S158      score 185.45, transient  456.7, activity 0.596
+	{0x0ea, 0x10e},	// B13567/S1238     score 185.23, transient  486.0, activity 0.499
+	{0x03e, 0x1a3},	// B12345/S01578    score 184.94, transient  388.3, activity 0.552
+	{0x17c, 0x125},	// B234568/S0258    score 184.83, transient  337.0, activity 0.583
+	{0x176, 0x14e},	// B124568/S12368   score 184.73, transient  428.8, activity 0.538
+};
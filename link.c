@@ -0,0 +1,329 @@
+/*
+ * link.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Shared world across several Hacklaces (daisy chain over the USART)
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include "config.h"
+#include "dot_matrix.h"
+#include "life.h"
+#include "link.h"
+
+#ifdef __AVR__
+	#include <avr/io.h>
+	#include <avr/interrupt.h>
+	#include <avr/eeprom.h>
+#endif
+
+#if (LINK_NODES > 0) || !defined(__AVR__)
+
+
+/**********
+ * makros *
+ **********/
+
+#define FRAME_SIZE		(2 * LINK_NODES)		// number of data bytes per frame
+#define LEFT_HALO		0						// indices within link_t.world
+#define FIRST_COL		1
+#define LAST_COL		DISP_COLUMNS
+#define RIGHT_HALO		(DISP_COLUMNS + 1)
+
+
+/*************
+ * functions *
+ *************/
+
+/*======================================================================
+	Function:		linkReset
+	Input:			world (DISP_COLUMNS + 2 bytes)
+					position of this board within the ring
+	Output:			none
+	Description:	Initialize the protocol state of one board.
+======================================================================*/
+void linkReset(link_t* l, uint8_t* world, uint8_t node)
+{
+	l->world = world;
+	l->node = node;
+	l->pass = LINK_IDLE;
+	l->pos = FRAME_SIZE;					// not within a frame
+	l->ready = 0;
+	l->reseed = 0;
+	l->changed = 1;
+	l->request = 0;
+	l->timeout = 0;
+	l->errors = 0;
+}
+
+
+/*======================================================================
+	Function:		linkStart
+	Input:			none
+	Output:			none
+	Description:	Start the edge exchange for the next generation (master only).
+					Call this function periodically. An exchange that is
+					still running after LINK_TIMEOUT calls has lost a byte
+					and is started again; if its scatter frame had been
+					sent, the new exchange reseeds the world.
+======================================================================*/
+void linkStart(link_t* l)
+{
+	uint8_t i;
+
+	if ((l->node != 0) || l->ready) {
+		return;
+	}
+	if (l->pass != LINK_IDLE) {
+		if (++l->timeout < LINK_TIMEOUT) {
+			return;							// previous exchange is still running
+		}
+		if (l->errors != 0xFF) {
+			l->errors++;
+		}
+		if (l->pass != LINK_GATHER) {
+			l->request = 1;					// the boards may be a generation apart
+		}
+	}
+	l->timeout = 0;
+	l->pos = FRAME_SIZE;					// ignore the rest of a frame that is still coming back
+	l->pass = LINK_GATHER;
+	l->put(l, LINK_SYNC_GATHER | (l->changed ? LINK_CHANGED : 0) | (l->request ? LINK_RESEED : 0));
+	l->put(l, l->world[FIRST_COL]);
+	l->put(l, l->world[LAST_COL]);
+	for (i = 2; i < FRAME_SIZE; i++) {
+		l->put(l, 0);						// slots of the other boards
+	}
+}
+
+
+/*======================================================================
+	Function:		linkRequestReseed
+	Input:			none
+	Output:			none
+	Description:	Ask the master to replace the world by a new one (e.g.
+					after a button press). All boards seed their parts
+					after one of the next exchanges (link.reseed).
+======================================================================*/
+void linkRequestReseed(link_t* l)
+{
+	l->request = 1;
+}
+
+
+/*======================================================================
+	Function:		linkDecide
+	Input:			sync byte of the returned gather frame
+	Output:			sync byte of the scatter frame
+	Description:	Master: reseed bookkeeping for the whole world.
+======================================================================*/
+static uint8_t linkDecide(link_t* l, uint8_t sync)
+{
+	l->reseed = lifeReseedDue(!(sync & LINK_CHANGED));
+	if (!l->reseed && ((sync & LINK_RESEED) || l->request)) {
+		lifeResetCounters();
+		l->reseed = 1;
+	}
+	l->request = 0;
+	return LINK_SYNC_SCATTER | (l->reseed ? LINK_RESEED : 0);
+}
+
+
+/*======================================================================
+	Function:		linkReceive
+	Input:			received byte
+	Output:			none
+	Description:	Process one byte received from the previous board.
+					Call this function from the receive interrupt.
+======================================================================*/
+void linkReceive(link_t* l, uint8_t byte)
+{
+	uint8_t slot;
+	uint8_t left = (l->node == 0) ? (LINK_NODES - 1) : (l->node - 1);
+	uint8_t right = (l->node == LINK_NODES - 1) ? 0 : (l->node + 1);
+
+	if (byte & 0x80) {						// --- sync byte ---
+		if (l->pos != FRAME_SIZE && l->errors != 0xFF) {
+			l->errors++;					// previous frame was truncated
+		}
+		l->pos = 0;
+		if (l->node == 0) {
+			if ((byte & LINK_SYNC_MASK) == LINK_SYNC_GATHER && l->pass == LINK_GATHER) {
+				l->pass = LINK_SCATTER;		// gather frame is complete -> send it out again as scatter frame
+				l->put(l, linkDecide(l, byte));
+			}
+			else if ((byte & LINK_SYNC_MASK) == LINK_SYNC_SCATTER && l->pass == LINK_SCATTER) {
+				l->pass = LINK_RETURN;
+			}
+			else if (l->errors != 0xFF) {
+				l->errors++;				// frame of an exchange that has timed out
+			}
+		}
+		else if ((byte & LINK_SYNC_MASK) == LINK_SYNC_GATHER) {
+			if (l->ready && l->errors != 0xFF) {
+				l->errors++;				// previous generation has not been computed yet
+			}
+			if (l->changed) {
+				byte |= LINK_CHANGED;
+			}
+			if (l->request) {
+				byte |= LINK_RESEED;
+				l->request = 0;
+			}
+			l->pass = LINK_GATHER;
+			l->put(l, byte);
+		}
+		else {
+			l->reseed = (byte & LINK_RESEED) ? 1 : 0;
+			l->pass = LINK_SCATTER;
+			l->put(l, byte);
+		}
+		return;
+	}
+
+	if (l->pos >= FRAME_SIZE) {				// --- data byte outside of a frame ---
+		if (l->errors != 0xFF) {
+			l->errors++;
+		}
+		return;
+	}
+
+	slot = l->pos++;
+	if (l->node == 0 && (l->pass == LINK_IDLE || l->pass == LINK_GATHER)) {
+		return;								// rest of a frame of an exchange that has timed out
+	}
+	if (l->pass == LINK_RETURN) {			// scatter frame came back -> all boards have their halos
+		if (slot == FRAME_SIZE - 1) {
+			l->pass = LINK_IDLE;
+			l->ready = 1;
+		}
+		return;
+	}
+	if (l->pass == LINK_SCATTER) {			// data of the complete gather frame
+		if (slot == 2 * left + 1) {
+			l->world[LEFT_HALO] = byte;		// right edge of the left neighbour
+		}
+		if (slot == 2 * right) {
+			l->world[RIGHT_HALO] = byte;	// left edge of the right neighbour
+		}
+	}
+	if (l->node != 0) {
+		if (l->pass == LINK_GATHER) {
+			if (slot == 2 * l->node) {
+				byte = l->world[FIRST_COL];
+			}
+			else if (slot == 2 * l->node + 1) {
+				byte = l->world[LAST_COL];
+			}
+		}
+		else if (slot == FRAME_SIZE - 1) {
+			l->pass = LINK_IDLE;			// scatter frame has passed -> halos are valid
+			l->ready = 1;
+		}
+	}
+	l->put(l, byte);
+}
+
+
+#ifdef __AVR__
+
+/********************
+ * global variables *
+ ********************/
+
+link_t link;
+uint8_t link_node EEMEM = 0;				// position of this board within the ring
+
+static uint8_t tx_buffer[LINK_TX_SIZE];
+static volatile uint8_t tx_head = 0;		// index of the next free byte
+static volatile uint8_t tx_tail = 0;		// index of the next byte to be sent
+
+
+/*======================================================================
+	Function:		linkPut
+	Input:			byte
+	Output:			none
+	Description:	Append a byte to the transmit buffer. Bytes are dropped
+					if the buffer is full, the master then restarts the
+					exchange after its timeout (see linkStart).
+======================================================================*/
+static void linkPut(link_t* l, uint8_t byte)
+{
+	uint8_t next = (tx_head + 1) & (LINK_TX_SIZE - 1);
+
+	if (next == tx_tail) {
+		if (l->errors != 0xFF) {
+			l->errors++;
+		}
+		return;
+	}
+	tx_buffer[tx_head] = byte;
+	tx_head = next;
+	UCSRB |= (1<<UDRIE);					// start transmission
+}
+
+
+/*======================================================================
+	Function:		linkInit
+	Input:			world (display memory)
+	Output:			none
+	Description:	Initialize the USART (8N1, LINK_BAUD) and the protocol state.
+======================================================================*/
+void linkInit(uint8_t* world)
+{
+	linkReset(&link, world, eeprom_read_byte(&link_node));
+	link.put = linkPut;
+
+	UBRRH = (uint8_t)(LINK_UBRR >> 8);
+	UBRRL = (uint8_t)LINK_UBRR;
+	UCSRA = (1<<U2X);						// double speed
+	UCSRC = (3<<UCSZ0);						// 8 data bits, no parity, 1 stop bit
+	UCSRB = (1<<RXCIE)|(1<<RXEN)|(1<<TXEN);
+}
+
+
+/******************************
+ * interrupt service routines *
+ ******************************/
+
+ISR(USART0_RX_vect)
+// byte received from the previous board
+{
+	linkReceive(&link, UDR);
+}
+
+
+ISR(USART0_UDRE_vect)
+// transmit buffer of the USART is empty
+{
+	if (tx_head == tx_tail) {
+		UCSRB &= ~(1<<UDRIE);
+	}
+	else {
+		UDR = tx_buffer[tx_tail];
+		tx_tail = (tx_tail + 1) & (LINK_TX_SIZE - 1);
+	}
+}
+
+#endif /* __AVR__ */
+
+#endif /* LINK_NODES */
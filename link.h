@@ -0,0 +1,107 @@
+/*
+ * link.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Shared world across several Hacklaces (daisy chain over the USART)
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+// The boards form a ring: TXD of every board is connected to RXD of the next one.
+// Board 0 (master) owns the leftmost DISP_COLUMNS columns of the world, board 1
+// the next ones and so on. Every generation the master sends two frames around
+// the ring, each consisting of a sync byte and two edge columns per board:
+//
+//   gather frame:  every board inserts its own left and right edge column into its slots
+//   scatter frame: every board copies the edges of its neighbours into its halo columns
+//
+// When the scatter frame has passed a board, its halo columns are up to date and
+// link.ready is set. All boards have received the edges of the same generation
+// once the scatter frame has returned to the master (barrier).
+//
+// The master decides when the whole world is replaced: every board sets
+// LINK_CHANGED in the sync byte of the gather frame if its part has changed in
+// the last generation (LINK_RESEED if the button asks for a new world). With
+// the result the master runs lifeReseedDue() and sets LINK_RESEED in the sync
+// byte of the scatter frame, so all boards seed their parts at the same
+// generation (link.reseed) instead of computing it.
+//
+// Bytes can get lost (full transmit buffer, board asleep). The master then
+// restarts the exchange after LINK_TIMEOUT calls of linkStart(). If the
+// scatter frame had already been sent, some boards may have computed the
+// generation while others have not, so the restarted exchange reseeds.
+
+#ifndef LINK_H_
+#define LINK_H_
+
+
+/*************
+ * constants *
+ *************/
+
+#define LINK_SYNC_GATHER	0x80		// sync bytes (edge columns never have bit 7 set)
+#define LINK_SYNC_SCATTER	0x81
+#define LINK_SYNC_MASK		0x81		// sync byte without the flags
+#define LINK_CHANGED		0x02		// gather: the part of a board has changed in the last generation
+#define LINK_RESEED			0x04		// gather: a board asks for a new world, scatter: seed it
+
+#define LINK_IDLE			0			// link_t.pass
+#define LINK_GATHER			1
+#define LINK_SCATTER		2
+#define LINK_RETURN			3			// master only: scatter frame is coming back
+
+#define LINK_TX_SIZE		32			// size of the transmit buffer (power of 2, > 2 * LINK_NODES)
+#define LINK_TIMEOUT		4			// calls of linkStart() until the master restarts an exchange
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct link_s {
+	uint8_t* world;				// halo column, own columns, halo column
+	uint8_t node;				// position within the ring (0 = master)
+	uint8_t pass;				// frame currently passing (LINK_IDLE, LINK_GATHER, LINK_SCATTER)
+	uint8_t pos;				// index of the next data byte within the current frame
+	volatile uint8_t ready;		// 1 = halo columns are valid for the next generation
+	uint8_t reseed;				// 1 = seed a new world instead of computing the next generation (valid with ready)
+	uint8_t changed;			// 1 = own part has changed in the last generation (set by main)
+	volatile uint8_t request;	// 1 = ask the master for a new world
+	uint8_t timeout;			// master: calls of linkStart() since the exchange has been started
+	uint8_t errors;				// number of protocol errors (saturating)
+	void (*put)(struct link_s* link, uint8_t byte);	// transmit one byte to the next board
+} link_t;
+
+#ifdef __AVR__
+	extern link_t link;
+#endif
+
+
+/**************
+ * prototypes *
+ **************/
+void linkReset(link_t* l, uint8_t* world, uint8_t node);
+void linkStart(link_t* l);
+void linkRequestReseed(link_t* l);
+void linkReceive(link_t* l, uint8_t byte);
+void linkInit(uint8_t* world);
+
+
+#endif /* LINK_H_ */
@@ -0,0 +1,23 @@
+// generated by patenc: compressed pattern library (see PATTERN_LIBRARY in config.h)
+// per pattern: (width - 1) << 3 | (height - 1), then a bit stream (from bit 0)
+// with 0 + height bits = column, 10 = empty column, 11 = previous column
+#define PATTERN_ROWS	7
+#define PATTERN_COUNT	15
+
+const uint8_t patterns[] PROGMEM = {
+	0x32,0xa8,0x11,0x3e,                              // Acorn, 7x3
+	0x1a,0xc6,0x26,                                   // B-heptomino, 4x3
+	0x3a,0xc4,0x15,0x2a,0x02,                         // Diehard, 8x3
+	0x5b,0x48,0xb1,0xaa,0xc2,0x84,0x01,               // Glider pair, 12x4
+	0x12,0xa8,0x0c,                                   // Glider, 3x3
+	0x23,0x5c,0xc2,0x15,                              // Lightweight spaceship, 5x4
+	0x4a,0xb4,0xd2,0xaf,0x34,                         // Pentadecathlon, 10x3
+	0x12,0x2e,0x0e,                                   // Pi-heptomino, 3x3
+	0x12,0xe4,0x02,                                   // R-pentomino, 3x3
+	0x14,0x82,0x2e,0x00,                              // Thunderbird, 3x5
+	0x1b,0x66,0x3c,                                   // Beacon, 4x4
+	0x10,0x3e,                                        // Blinker, 3x1
+	0x1b,0x04,0x1b,0x04,                              // Clock, 4x4
+	0x2d,0x8e,0x87,0x3f,                              // Figure eight, 6x6
+	0x19,0xf4,0x02,                                   // Toad, 4x2
+};
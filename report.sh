@@ -0,0 +1,138 @@
+#!/bin/sh
+# Footprint and timing report for the Hacklace firmware.
+#
+# usage: report.sh <elf> <baseline> <threshold> [update]
+#
+# Collects flash and RAM usage from the ELF file, the stack peak from the
+# -fstack-usage output (*.su) along the worst case call chains in
+# STACK_CHAINS and the cycle counts printed by the simulator benchmark
+# (BENCH_CMD, see bench.c). Every value is compared against the baseline
+# file. The script fails if a value grows by more than <threshold> percent
+# or if the device limits (FLASH_SIZE, RAM_SIZE) are exceeded.
+# With "update" the baseline is rewritten instead; without it a missing
+# baseline is an error.
+
+ELF=$1
+BASELINE=$2
+THRESHOLD=${3:-2}
+UPDATE=$4
+
+: ${SIZE:=avr-size}
+: ${FLASH_SIZE:=4096}
+: ${RAM_SIZE:=256}
+# call chains of the stack peak: contexts separated by "|" add up (interrupts
+# nest into the main context, and the other interrupts into the system timer,
+# which enables them for dmScroll), within a context the deepest of the chains
+# separated by "," counts. Names are matched exactly; functions without an
+# entry in the .su files (inlined, library) count 0, the naked assembler
+# interrupts are taken from ASM_FRAMES. Only one of the lifeStep kernels is
+# compiled.
+: ${STACK_CHAINS:="
+	main GoToSleep dmWakeUp dmUpdatePorts dmColumnPorts,
+	main GoToSleep dmClearDisplay dmUpdatePorts dmColumnPorts,
+	main GoToSleep WatchdogSleep,
+	main Doze WatchdogSleep,
+	main NextBrightness SetColumnFreq,
+	main dmShowFrame dmUpdatePorts dmColumnPorts,
+	main dmProduce lifeStepRef, main dmProduce lifeStepLut, main dmProduce lifeStepRows,
+	main dmProduce lifeStepBlocked, main dmProduce dmWakeUp dmUpdatePorts dmColumnPorts,
+	main dmScroll lifeStepRef, main dmScroll lifeStepLut, main dmScroll lifeStepRows,
+	main dmScroll lifeStepBlocked, main dmScroll dmWakeUp dmUpdatePorts dmColumnPorts
+|
+	__vector_14 dmScroll lifeStepRef, __vector_14 dmScroll lifeStepLut,
+	__vector_14 dmScroll lifeStepRows, __vector_14 dmScroll lifeStepBlocked,
+	__vector_14 dmScroll lifeReseedDue,
+	__vector_14 dmScroll dmUpdatePorts dmColumnPorts,
+	__vector_14 dmScroll dmWakeUp dmUpdatePorts dmColumnPorts,
+	__vector_14 dmScroll dmWakeUp dmRandomize,
+	__vector_14 dmScroll dmWakeUp dmDecodePattern,
+	__vector_14 dmScroll dmWakeUp lifeNextRule,
+	__vector_14 dmNextFrame dmUpdatePorts dmColumnPorts,
+	__vector_14 linkStart linkPut,
+	__vector_14 ButtonTick ButtonChange ButtonPush,
+	__vector_14 ClockGovernor SetClockDiv SetColumnFreq
+|
+	__vector_4, __vector_12, __vector_7 linkReceive linkPut, __vector_7 linkReceive lifeReseedDue,
+	__vector_7 linkReceive lifeResetCounters, __vector_7, __vector_8,
+	__vector_18, __vector_20 ButtonChange ButtonPush
+"}
+# frames of the naked interrupts in dot_matrix.c ("<name> <bytes pushed>",
+# the return address is added as for every function)
+: ${ASM_FRAMES:="__vector_4 5 __vector_12 3"}
+# firmware objects only (bench.su belongs to the benchmark)
+: ${SU_FILES:=$(ls *.su 2>/dev/null | grep -v '^bench\.su$')}
+
+CURRENT=$(mktemp)
+trap 'rm -f "$CURRENT"' EXIT
+
+# --- footprint ---
+$SIZE -A "$ELF" | awk '
+	$1 == ".text" { text = $2 }
+	$1 == ".data" { data = $2 }
+	$1 == ".bss"  { bss = $2 }
+	END { printf "text %d\ndata %d\nbss %d\n", text, data, bss }' > "$CURRENT" || exit 1
+
+# --- stack peak (static estimate, 2 bytes return address per call) ---
+cat $SU_FILES 2>/dev/null | awk -v chains="$STACK_CHAINS" -v asm="$ASM_FRAMES" '
+	BEGIN { n = split(asm, a, " "); for (i = 1; i < n; i += 2) frame[a[i]] = a[i + 1] + 0 }
+	{ split($1, a, ":"); f = a[4]; if ($2 > frame[f]) frame[f] = $2 }
+	END {
+		n = split(chains, ctx, "|")
+		for (i = 1; i <= n; i++) {
+			worst = 0
+			k = split(ctx[i], chain, ",")
+			for (j = 1; j <= k; j++) {
+				m = split(chain[j], fn, " ")
+				sum = 0
+				for (l = 1; l <= m; l++) {
+					if (fn[l] in frame) sum += frame[fn[l]] + 2
+				}
+				if (sum > worst) worst = sum
+			}
+			total += worst
+		}
+		printf "stack %d\n", total
+	}' >> "$CURRENT"
+
+# --- cycle counts from the simulator benchmark ("<name> <cycles>" lines) ---
+if [ -n "$BENCH_CMD" ]; then
+	# the simulator may prefix the UART output, so only the match itself is used
+	$BENCH_CMD 2>&1 | tr -d '\r' | awk 'match($0, /cycles_[a-z_]+ [0-9]+/) { print substr($0, RSTART, RLENGTH) }' >> "$CURRENT"
+else
+	echo "note: BENCH_CMD not set, cycle counts are not reported" >&2
+fi
+
+# --- device limits ---
+STATUS=0
+awk -v flash="$FLASH_SIZE" -v ram="$RAM_SIZE" '
+	{ v[$1] = $2 }
+	END {
+		f = v["text"] + v["data"]; r = v["data"] + v["bss"] + v["stack"]
+		printf "flash %d / %d bytes, ram %d / %d bytes (including stack)\n", f, flash, r, ram
+		exit (f > flash || r > ram)
+	}' "$CURRENT" || { echo "FAIL: device limits exceeded"; STATUS=1; }
+
+if [ "$UPDATE" = "update" ]; then
+	cp "$CURRENT" "$BASELINE"
+	echo "baseline $BASELINE written"
+	cat "$BASELINE"
+	exit $STATUS
+fi
+if [ ! -f "$BASELINE" ]; then
+	cat "$CURRENT"
+	echo "FAIL: no baseline $BASELINE, run \"make report-baseline\" to record the values above"
+	exit 1
+fi
+
+# --- comparison against the baseline ---
+awk -v threshold="$THRESHOLD" '
+	NR == FNR { base[$1] = $2; next }
+	{
+		old = base[$1]; delta = (old > 0) ? 100.0 * ($2 - old) / old : 0
+		mark = (delta > threshold) ? "  REGRESSION" : ""
+		printf "%-24s %8d %8s %+7.1f%%%s\n", $1, $2, (old == "") ? "-" : old, delta, mark
+		if (mark != "") failed = 1
+	}
+	END { exit failed }' "$BASELINE" "$CURRENT" || { echo "FAIL: regression above $THRESHOLD %"; STATUS=1; }
+
+exit $STATUS
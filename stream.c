@@ -0,0 +1,164 @@
+/*
+ * stream.c
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Streaming mode: frames sent by a host over the USART are shown
+					instead of the generations of the board
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "config.h"
+#include "dot_matrix.h"
+#include "stream.h"
+
+#if STREAM
+
+#if LINK_NODES > 0
+	#error "The streaming mode and the daisy chain both use the USART"
+#endif
+
+#if CLOCK_GOVERNOR
+	#error "The baud rate of the streaming mode depends on the system clock, so it does not work with the clock governor"
+#endif
+
+#if LOOKAHEAD_FRAMES > 0
+	#error "The streaming mode writes the display memory directly and does not work with the look-ahead"
+#endif
+
+#if DISP_ROWS > 7
+	#error "The streaming mode needs bit 7 of a column for the sync byte"
+#endif
+
+
+/********************
+ * global variables *
+ ********************/
+
+stream_t stream;
+
+
+/*************
+ * functions *
+ *************/
+
+/*======================================================================
+	Function:		streamInit
+	Input:			none
+	Output:			none
+	Description:	Initialize the USART (8N1, STREAM_BAUD, receiver only)
+					and the protocol state.
+======================================================================*/
+void streamInit(void)
+{
+	stream.back = 0;
+	stream.pos = STREAM_IDLE;
+	stream.ready = 0;
+
+	UBRRH = (uint8_t)(STREAM_UBRR >> 8);
+	UBRRL = (uint8_t)STREAM_UBRR;
+	UCSRA = (1<<U2X);						// double speed
+	UCSRC = (3<<UCSZ0);						// 8 data bits, no parity, 1 stop bit
+	UCSRB = (1<<RXCIE)|(1<<RXEN);
+}
+
+
+/*======================================================================
+	Function:		streamFrame
+	Input:			none
+	Output:			new frame (DISP_MAX bytes), NULL if there is none
+	Description:	Called by main(). The frame stays valid until
+					streamRelease().
+======================================================================*/
+const uint8_t* streamFrame(void)
+{
+	if (!stream.ready) {
+		return NULL;
+	}
+	return stream.buf[stream.back ^ 1];		// back does not change while ready is set
+}
+
+
+/*======================================================================
+	Function:		streamRelease
+	Input:			none
+	Output:			none
+	Description:	Hand the buffer of the frame returned by streamFrame()
+					back to the receive interrupt.
+======================================================================*/
+void streamRelease(void)
+{
+	stream.ready = 0;
+}
+
+
+/******************************
+ * interrupt service routines *
+ ******************************/
+
+ISR(USART0_RX_vect)
+// byte received from the host
+{
+	uint8_t status = UCSRA;
+	uint8_t byte = UDR;
+
+	if (status & ((1<<FE)|(1<<DOR))) {		// framing error or overrun -> wait for the next packet
+		if (stream.pos != STREAM_IDLE && stream.errors != 0xFF) {
+			stream.errors++;
+		}
+		stream.pos = STREAM_IDLE;
+		return;
+	}
+	if (byte & 0x80) {						// --- sync byte ---
+		if (stream.pos != STREAM_IDLE && stream.errors != 0xFF) {
+			stream.errors++;				// previous packet was truncated
+		}
+		stream.pos = 0;
+		stream.sum = 0;
+	}
+	else if (stream.pos < DISP_MAX) {		// --- column ---
+		stream.buf[stream.back][stream.pos++] = byte;
+		stream.sum = STREAM_SUM(stream.sum, byte);
+	}
+	else if (stream.pos == DISP_MAX) {		// --- checksum ---
+		stream.pos = STREAM_IDLE;
+		if (byte != stream.sum) {
+			if (stream.errors != 0xFF) {
+				stream.errors++;
+			}
+		}
+		else if (stream.ready) {			// main() still has the previous frame
+			if (stream.dropped != 0xFF) {
+				stream.dropped++;
+			}
+		}
+		else {
+			stream.back ^= 1;
+			stream.ready = 1;
+			stream.frames++;
+		}
+	}
+}
+
+#endif /* STREAM */
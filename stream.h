@@ -0,0 +1,83 @@
+/*
+ * stream.h
+ *
+ */ 
+
+/**********************************************************************************
+
+Description:		Streaming mode: frames sent by a host over the USART are shown
+					instead of the generations of the board
+Author:				Daniel Friesel
+License:			This software is distributed under the creative commons license
+					CC-BY-NC-SA.
+Disclaimer:			This software is provided by the copyright holder "as is" and any 
+					express or implied warranties, including, but not limited to, the 
+					implied warranties of merchantability and fitness for a particular 
+					purpose are disclaimed. In no event shall the copyright owner or 
+					contributors be liable for any direct, indirect, incidental, 
+					special, exemplary, or consequential damages (including, but not 
+					limited to, procurement of substitute goods or services; loss of 
+					use, data, or profits; or business interruption) however caused 
+					and on any theory of liability, whether in contract, strict 
+					liability, or tort (including negligence or otherwise) arising 
+					in any way out of the use of this software, even if advised of 
+					the possibility of such damage.
+					
+**********************************************************************************/
+
+// A packet consists of a sync byte, the DISP_MAX columns of the display memory
+// (bit y = row y) and a checksum over the columns:
+//
+//   STREAM_SYNC  column 0  column 1  ...  column DISP_MAX - 1  checksum
+//
+// Only the sync byte has bit 7 set, so the receiver finds the start of the next
+// packet after any error. The receive interrupt collects the columns in a back
+// buffer and flips the buffers when the checksum is correct; main() copies the
+// new frame into the display memory, and the display interrupt switches to it
+// at column 0 as with every generation. A frame that arrives before main() has
+// taken the previous one is dropped. The generations of the board go on from
+// the last frame STREAM_HOLD system ticks after it.
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+
+/*************
+ * constants *
+ *************/
+
+#define STREAM_SYNC			0x80		// start of a packet (columns never have bit 7 set)
+#define STREAM_PACKET		(DISP_MAX + 2)	// bytes per packet
+#define STREAM_IDLE			(DISP_MAX + 1)	// stream_t.pos outside of a packet
+
+// checksum: rotate the 7 bit sum left and add the column (XOR), starting with 0
+#define STREAM_SUM(sum, col)	((uint8_t)(((((sum) << 1) | ((sum) >> 6)) & 0x7F) ^ (col)))
+
+
+/*********
+ * types *
+ *********/
+
+typedef struct {
+	uint8_t buf[2][DISP_MAX];	// frame being received / last complete frame
+	uint8_t back;				// index of the buffer being received
+	uint8_t pos;				// index of the next column (DISP_MAX = checksum, STREAM_IDLE = wait for sync)
+	uint8_t sum;				// checksum of the columns received so far
+	volatile uint8_t ready;		// 1 = buf[back ^ 1] holds a frame main() has not taken yet
+	uint16_t frames;			// number of complete frames
+	uint8_t errors;				// number of damaged packets (saturating)
+	uint8_t dropped;			// number of frames main() was too slow for (saturating)
+} stream_t;
+
+extern stream_t stream;
+
+
+/**************
+ * prototypes *
+ **************/
+void streamInit(void);
+const uint8_t* streamFrame(void);
+void streamRelease(void);
+
+
+#endif /* STREAM_H_ */